@@ -0,0 +1,399 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - benchmark.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "commandLine.h"
+#include "treePreset.h"
+#include "treeBuilder.h"
+#include "treeProgress.h"
+#include "profiler.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    const char* PRESETS[] = { "LowpolyTree", "MediumpolyTree", "HighpolyTree", "TwistedTree" };
+
+    /**
+    * Settings for a single run of the benchmark
+    */
+    struct BenchmarkCase
+    {
+        const TreePreset* preset = nullptr;     ///< The preset to generate
+        unsigned int iterations = 0;            ///< Iterations of the rule
+        unsigned int faces = 0;                 ///< Faces of the trunk and branches
+    };
+
+    /**
+    * Counts the geometry of the tree into the running stage of the profiler
+    * without keeping it. Instanced leaves are counted as if baked
+    */
+    class CountingOutput : public TreeOutput, private LeafInstanceSink
+    {
+    public:
+
+        explicit CountingOutput(Profiler& profiler) :
+            m_profiler(profiler)
+        {
+        }
+
+        virtual void AddMesh(const MeshBuffer& mesh,
+                             const std::string&,
+                             int,
+                             bool,
+                             const std::vector<int>&) override
+        {
+            m_profiler.Count("meshes", 1);
+            m_profiler.Count("vertices", mesh.vertices.size());
+            m_profiler.Count("faces", mesh.polycounts.size());
+        }
+
+        virtual void AddCurve(const std::vector<Float3>& points,
+                              const std::string&,
+                              int) override
+        {
+            m_profiler.Count("curves", 1);
+            m_profiler.Count("vertices", points.size());
+        }
+
+        virtual LeafInstanceSink& AddLeafInstancer(const MeshBuffer& topology,
+                                                   const std::string&) override
+        {
+            m_leafFaces = topology.polycounts.size();
+            return *this;
+        }
+
+    private:
+
+        virtual void AddPrototype(const std::vector<Float3>& vertices) override
+        {
+            m_leafVertices = vertices.size();
+        }
+
+        virtual void SetInstances(const std::vector<LeafInstance>& instances) override
+        {
+            m_profiler.Count("vertices", instances.size() * m_leafVertices);
+            m_profiler.Count("faces", instances.size() * m_leafFaces);
+        }
+
+        Profiler& m_profiler;       ///< Profiler to count into
+        size_t m_leafVertices = 0;  ///< Vertices of each leaf prototype
+        size_t m_leafFaces = 0;     ///< Faces of each leaf prototype
+    };
+
+    /**
+    * Resets the peak memory of the process where supported
+    */
+    void ResetPeakMemory()
+    {
+#ifdef __linux__
+        std::ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+#endif
+    }
+
+    /**
+    * @return the peak memory used by the process in bytes
+    */
+    size_t PeakMemory()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        size_t peak = static_cast<size_t>(usage.ru_maxrss) * 1024;
+
+        // Linux keeps the high-water mark after the peak is reset
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while(std::getline(status, line))
+        {
+            if(line.compare(0, 6, "VmHWM:") == 0)
+            {
+                peak = static_cast<size_t>(std::stoull(line.substr(6))) * 1024;
+            }
+        }
+        return peak;
+#endif
+#endif
+    }
+
+    /**
+    * Reads a comma separated list of numbers
+    * @param list The list given
+    * @param values Filled with the numbers
+    * @return whether the list was valid
+    */
+    bool ReadList(const std::string& list, std::vector<unsigned int>& values)
+    {
+        values.clear();
+        std::istringstream stream(list);
+        std::string value;
+        while(std::getline(stream, value, ','))
+        {
+            char* end = nullptr;
+            values.push_back(static_cast<unsigned int>(strtoul(value.c_str(), &end, 10)));
+            if(value.empty() || *end != '\0')
+            {
+                return false;
+            }
+        }
+        return !values.empty();
+    }
+
+    /**
+    * Generates a tree for the case, keeping the fastest of several runs
+    * @param benchmark The settings for the run
+    * @param seed The seed of the tree
+    * @param repeats The number of times to generate the tree
+    * @param stream The stream to write the JSON results to
+    * @return whether generation succeeded
+    */
+    bool RunCase(const BenchmarkCase& benchmark,
+                 unsigned int seed,
+                 unsigned int repeats,
+                 std::ostream& stream)
+    {
+        CommandLineArguments arguments;
+        if(!arguments.Parse(benchmark.preset->Arguments()))
+        {
+            std::cerr << arguments.Error() << std::endl;
+            return false;
+        }
+
+        TreeParameters parameters;
+        arguments.Read(parameters);
+        parameters.iterations = benchmark.iterations;
+        parameters.mesh.trunkfaces = benchmark.faces;
+        parameters.mesh.branchfaces = benchmark.faces;
+        parameters.tree.seed = seed;
+
+        ResetPeakMemory();
+        Profiler best;
+        double bestTotal = 0.0;
+
+        // Repeats reuse the memory of the first run as previews in Maya do
+        TreeWorkspace workspace;
+
+        for(unsigned int repeat = 0; repeat < repeats; ++repeat)
+        {
+            Profiler profiler;
+            SilentProgress progress;
+            CountingOutput output(profiler);
+            {
+                Profiler::Scope total(&profiler, "Total");
+                TreeBuilder builder(parameters, progress, &workspace);
+                builder.SetProfiler(&profiler);
+                if(!builder.BuildSkeleton() || !builder.CreateGeometry(output, "tf_tree_1"))
+                {
+                    return false;
+                }
+            }
+
+            const double time = profiler.Find("Total")->duration;
+            if(repeat == 0 || time < bestTotal)
+            {
+                bestTotal = time;
+                best = profiler;
+            }
+        }
+
+        stream << "    {\n"
+               << "      \"preset\": \"" << benchmark.preset->Name() << "\",\n"
+               << "      \"iterations\": " << benchmark.iterations << ",\n"
+               << "      \"faces\": " << benchmark.faces << ",\n"
+               << "      \"seed\": " << seed << ",\n"
+               << "      \"totalMs\": " << bestTotal << ",\n"
+               << "      \"peakMemoryBytes\": " << PeakMemory() << ",\n"
+               << "      \"stages\": [";
+
+        bool firstStage = true;
+        for(const Profiler::Stage& stage : best.Stages())
+        {
+            if(stage.name == "Total")
+            {
+                continue;
+            }
+
+            stream << (firstStage ? "\n" : ",\n") << "        { \"name\": \""
+                   << stage.name << "\", \"ms\": " << stage.duration;
+
+            const double seconds = stage.duration / 1000.0;
+            for(const auto& count : stage.counts)
+            {
+                stream << ", \"" << count.first << "\": " << count.second
+                       << ", \"" << count.first << "PerSecond\": "
+                       << (seconds > 0.0 ? count.second / seconds : 0.0);
+            }
+            stream << " }";
+            firstStage = false;
+        }
+        stream << "\n      ]\n    }";
+        return true;
+    }
+
+    /**
+    * Writes how to use the benchmark
+    * @param stream The stream to write to
+    */
+    void PrintUsage(std::ostream& stream)
+    {
+        stream << "Usage: treegen_benchmark [flags] [preset.mel ...]" << std::endl;
+        stream << "  -p -presets <string>   Folder of the shipped presets, default release/Tree Presets" << std::endl;
+        stream << "  -i -iterations <list>  Comma separated iterations, default the preset's and one more" << std::endl;
+        stream << "  -fa -faces <list>      Comma separated trunk and branch faces, default 4,8,16" << std::endl;
+        stream << "  -sd -seed <uint>       Seed of every tree, default 1" << std::endl;
+        stream << "  -n -repeat <uint>      Runs of each case keeping the fastest, default 3" << std::endl;
+        stream << "  -o -output <string>    File to write the JSON results to, default the console" << std::endl;
+    }
+}
+
+/**
+* Times each stage of generating the shipped presets across
+* iterations and face counts and writes the results as JSON
+*/
+int main(int argc, char** argv)
+{
+    std::string folder = "release/Tree Presets";
+    std::string outputFile;
+    std::vector<std::string> files;
+    std::vector<unsigned int> iterations;
+    std::vector<unsigned int> faces = { 4, 8, 16 };
+    unsigned int seed = 1;
+    unsigned int repeats = 3;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string flag(argv[i]);
+        const bool hasValue = i + 1 < argc;
+        const std::string value(hasValue ? argv[i + 1] : "");
+        std::vector<unsigned int> single;
+
+        if(flag == "-h" || flag == "-help")
+        {
+            PrintUsage(std::cout);
+            return 0;
+        }
+        else if(flag[0] != '-')
+        {
+            files.push_back(flag);
+            continue;
+        }
+        else if(hasValue && (flag == "-p" || flag == "-presets"))
+        {
+            folder = value;
+        }
+        else if(hasValue && (flag == "-o" || flag == "-output"))
+        {
+            outputFile = value;
+        }
+        else if(hasValue && (flag == "-i" || flag == "-iterations") && ReadList(value, iterations))
+        {
+        }
+        else if(hasValue && (flag == "-fa" || flag == "-faces") && ReadList(value, faces))
+        {
+        }
+        else if(hasValue && (flag == "-sd" || flag == "-seed") && ReadList(value, single))
+        {
+            seed = single[0];
+        }
+        else if(hasValue && (flag == "-n" || flag == "-repeat") && ReadList(value, single))
+        {
+            repeats = std::max(1u, single[0]);
+        }
+        else
+        {
+            std::cerr << "Invalid flag " << flag << std::endl;
+            PrintUsage(std::cerr);
+            return 1;
+        }
+        ++i;
+    }
+
+    if(files.empty())
+    {
+        for(const char* preset : PRESETS)
+        {
+            files.push_back(folder + "/" + preset + ".mel");
+        }
+    }
+
+    std::vector<TreePreset> presets(files.size());
+    for(unsigned int i = 0; i < files.size(); ++i)
+    {
+        if(!presets[i].Load(files[i]))
+        {
+            std::cerr << "Could not read preset " << files[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream file;
+    if(!outputFile.empty())
+    {
+        file.open(outputFile);
+        if(!file.is_open())
+        {
+            std::cerr << "Could not open " << outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& stream = outputFile.empty() ? std::cout : file;
+
+    stream << "{\n  \"benchmark\": \"treegen\",\n  \"cases\": [";
+
+    bool firstCase = true;
+    for(const TreePreset& preset : presets)
+    {
+        std::vector<unsigned int> presetIterations = iterations;
+        if(presetIterations.empty())
+        {
+            const unsigned int presetValue = static_cast<unsigned int>(
+                strtoul(preset.Value("gt_IterationsInput").c_str(), nullptr, 10));
+            presetIterations = { presetValue, presetValue + 1 };
+        }
+
+        for(unsigned int iteration : presetIterations)
+        {
+            for(unsigned int face : faces)
+            {
+                BenchmarkCase benchmark;
+                benchmark.preset = &preset;
+                benchmark.iterations = iteration;
+                benchmark.faces = face;
+
+                std::cerr << preset.Name() << " iterations " << iteration
+                          << " faces " << face << std::endl;
+
+                stream << (firstCase ? "\n" : ",\n");
+                if(!RunCase(benchmark, seed, repeats, stream))
+                {
+                    std::cerr << "Failed to generate " << preset.Name() << std::endl;
+                    return 1;
+                }
+                firstCase = false;
+            }
+        }
+    }
+
+    stream << "\n  ]\n}" << std::endl;
+    return 0;
+}
@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - commandLine.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "commandLine.h"
+
+#include <cstdlib>
+#include <algorithm>
+
+namespace
+{
+    const char* TRUE_VALUES[] = { "true", "on", "yes", "1" };
+    const char* FALSE_VALUES[] = { "false", "off", "no", "0" };
+
+    /**
+    * @param value The value given
+    * @param names The accepted spellings
+    * @return whether the value is one of the spellings
+    */
+    template<size_t N> bool IsOneOf(const std::string& value, const char* (&names)[N])
+    {
+        return std::find(std::begin(names), std::end(names), value) != std::end(names);
+    }
+
+    /**
+    * @param type The type of value given to a flag
+    * @return the name of the type
+    */
+    const char* TypeName(TreeArguments::ArgumentType type)
+    {
+        switch(type)
+        {
+        case TreeArguments::ARGUMENT_BOOLEAN:
+            return "bool";
+        case TreeArguments::ARGUMENT_UNSIGNED:
+            return "uint";
+        case TreeArguments::ARGUMENT_DOUBLE:
+            return "double";
+        default:
+            return "string";
+        }
+    }
+}
+
+bool CommandLineArguments::Parse(int argc, char** argv)
+{
+    return Parse(std::vector<std::string>(argv + 1, argv + argc));
+}
+
+bool CommandLineArguments::Parse(const std::vector<std::string>& arguments)
+{
+    const int argc = static_cast<int>(arguments.size());
+    for(int i = 0; i < argc; ++i)
+    {
+        const std::string& name = arguments[i];
+        if(name == "-h" || name == "-help")
+        {
+            m_help = true;
+            continue;
+        }
+
+        if(name == "-o" || name == "-output")
+        {
+            if(i + 1 >= argc)
+            {
+                m_error = "Missing file for " + name;
+                return false;
+            }
+            m_outputFile = arguments[++i];
+            continue;
+        }
+
+        const auto& flags = Flags();
+        auto flag = std::find_if(flags.begin(), flags.end(), [&name](const Flag& flag)
+        {
+            return name == flag.shortName || name == flag.longName;
+        });
+
+        if(flag == flags.end())
+        {
+            m_error = "Unknown flag " + name;
+            return false;
+        }
+
+        if(i + static_cast<int>(flag->arguments.size()) >= argc)
+        {
+            m_error = "Expected " + std::to_string(flag->arguments.size()) + " values for " + name;
+            return false;
+        }
+
+        std::vector<std::string>& values = m_values[flag->shortName];
+        values.clear();
+
+        for(ArgumentType type : flag->arguments)
+        {
+            const std::string& value = arguments[++i];
+            if(!IsValid(value, type))
+            {
+                m_error = "Expected " + std::string(TypeName(type)) +
+                    " for " + name + " but was given " + value;
+                return false;
+            }
+            values.push_back(value);
+        }
+    }
+    return true;
+}
+
+bool CommandLineArguments::IsValid(const std::string& value, ArgumentType type)
+{
+    char* end = nullptr;
+    switch(type)
+    {
+    case ARGUMENT_BOOLEAN:
+        return IsOneOf(value, TRUE_VALUES) || IsOneOf(value, FALSE_VALUES);
+    case ARGUMENT_UNSIGNED:
+        strtoul(value.c_str(), &end, 10);
+        return !value.empty() && value[0] != '-' && *end == '\0';
+    case ARGUMENT_DOUBLE:
+        strtod(value.c_str(), &end);
+        return !value.empty() && *end == '\0';
+    default:
+        return true;
+    }
+}
+
+const std::string& CommandLineArguments::Error() const
+{
+    return m_error;
+}
+
+const std::string& CommandLineArguments::OutputFile() const
+{
+    return m_outputFile;
+}
+
+bool CommandLineArguments::HelpRequested() const
+{
+    return m_help;
+}
+
+void CommandLineArguments::PrintUsage(std::ostream& stream)
+{
+    stream << "Usage: treegen [-o file.obj] [flags]" << std::endl;
+    stream << "  -o -output <string>" << std::endl;
+    stream << "  -h -help" << std::endl;
+
+    for(const Flag& flag : Flags())
+    {
+        stream << "  " << flag.shortName << " " << flag.longName;
+        for(ArgumentType type : flag.arguments)
+        {
+            stream << " <" << TypeName(type) << ">";
+        }
+        stream << std::endl;
+    }
+}
+
+const std::string* CommandLineArguments::Find(const char* flag, unsigned int index) const
+{
+    auto values = m_values.find(flag);
+    if(values == m_values.end() || index >= values->second.size())
+    {
+        return nullptr;
+    }
+    return &values->second[index];
+}
+
+bool CommandLineArguments::IsFlagSet(const char* flag) const
+{
+    return m_values.find(flag) != m_values.end();
+}
+
+void CommandLineArguments::Get(const char* flag, unsigned int index, bool& value) const
+{
+    if(const std::string* argument = Find(flag, index))
+    {
+        value = IsOneOf(*argument, TRUE_VALUES);
+    }
+}
+
+void CommandLineArguments::Get(const char* flag, unsigned int index, unsigned int& value) const
+{
+    if(const std::string* argument = Find(flag, index))
+    {
+        value = static_cast<unsigned int>(strtoul(argument->c_str(), nullptr, 10));
+    }
+}
+
+void CommandLineArguments::Get(const char* flag, unsigned int index, double& value) const
+{
+    if(const std::string* argument = Find(flag, index))
+    {
+        value = strtod(argument->c_str(), nullptr);
+    }
+}
+
+void CommandLineArguments::Get(const char* flag, unsigned int index, std::string& value) const
+{
+    if(const std::string* argument = Find(flag, index))
+    {
+        value = *argument;
+    }
+}
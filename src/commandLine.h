@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - commandLine.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeArguments.h"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+* Reads the tree flags from the command line. Takes the same flags as the
+* Maya command with booleans given as true/false, on/off, yes/no or 1/0
+*/
+class CommandLineArguments : public TreeArguments
+{
+public:
+
+    /**
+    * Reads the flags from the command line
+    * @param argc The number of arguments
+    * @param argv The arguments including the program name
+    * @return whether the flags and their values were valid
+    */
+    bool Parse(int argc, char** argv);
+
+    /**
+    * Reads the flags from a list of arguments
+    * @param arguments The arguments not including the program name
+    * @return whether the flags and their values were valid
+    */
+    bool Parse(const std::vector<std::string>& arguments);
+
+    /**
+    * @return the reason the command line could not be read
+    */
+    const std::string& Error() const;
+
+    /**
+    * @return the file to write the tree to
+    */
+    const std::string& OutputFile() const;
+
+    /**
+    * @return whether the usage was asked for
+    */
+    bool HelpRequested() const;
+
+    /**
+    * Writes all flags and the values they take
+    * @param stream The stream to write to
+    */
+    static void PrintUsage(std::ostream& stream);
+
+    virtual bool IsFlagSet(const char* flag) const override;
+    virtual void Get(const char* flag, unsigned int index, bool& value) const override;
+    virtual void Get(const char* flag, unsigned int index, unsigned int& value) const override;
+    virtual void Get(const char* flag, unsigned int index, double& value) const override;
+    virtual void Get(const char* flag, unsigned int index, std::string& value) const override;
+
+private:
+
+    /**
+    * Gets a value of a flag
+    * @param flag The short name of the flag
+    * @param index The index of the value for the flag
+    * @return the value or null if not given
+    */
+    const std::string* Find(const char* flag, unsigned int index) const;
+
+    /**
+    * Checks whether a value can be read as the type of the flag value
+    * @param value The value given
+    * @param type The type of the flag value
+    * @return whether the value is valid
+    */
+    static bool IsValid(const std::string& value, ArgumentType type);
+
+    std::map<std::string, std::vector<std::string>> m_values; ///< Values given for each flag by short name
+    std::string m_outputFile = "tree.obj";                    ///< The file to write the tree to
+    std::string m_error;                                      ///< The reason the command line could not be read
+    bool m_help = false;                                      ///< Whether the usage was asked for
+};
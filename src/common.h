@@ -35,5 +35,14 @@
 #include "maya/MFnNurbsCurve.h"
 #include "maya/MFnDependencyNode.h"
 #include "maya/MSelectionList.h"
+#include "maya/MFnSet.h"
+#include "maya/MFnTypedAttribute.h"
+#include "maya/MFnIntArrayData.h"
+#include "maya/MPlug.h"
+#include "maya/MFnArrayAttrsData.h"
+#include "maya/MVectorArray.h"
+#include "maya/MVector.h"
+#include "maya/MDoubleArray.h"
+#include "maya/MObjectHandle.h"
 
 using namespace std;
\ No newline at end of file
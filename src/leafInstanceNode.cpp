@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - leafInstanceNode.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "leafInstanceNode.h"
+
+LeafInstanceNode::LeafInstanceNode(MDagModifier& dagMod, 
+                                   const MeshBuffer& topology, 
+                                   const MString& name, 
+                                   MObject& parent,
+                                   MayaMeshArrays& arrays) :
+    m_dagMod(dagMod),
+    m_arrays(arrays),
+    m_topology(topology),
+    m_name(name),
+    m_parent(parent)
+{
+    m_instancer = m_dagMod.createNode("instancer", m_parent);
+    m_dagMod.renameNode(m_instancer, m_name);
+}
+
+void LeafInstanceNode::AddPrototype(const std::vector<Float3>& vertices)
+{
+    m_topology.vertices = vertices;
+    MObject prototype = CreateMayaMesh(m_topology, m_arrays);
+
+    const unsigned int index = static_cast<unsigned int>(m_prototypes.size());
+    m_dagMod.renameNode(prototype, m_name + "_Prototype" + index);
+    m_dagMod.reparentNode(prototype, m_parent);
+
+    // Prototypes are only seen through the instancer
+    MFnDagNode prototypeFn(prototype);
+    prototypeFn.findPlug("visibility", true).setValue(false);
+
+    MFnDependencyNode instancerFn(m_instancer);
+    m_dagMod.connect(prototypeFn.findPlug("matrix", true), 
+        instancerFn.findPlug("inputHierarchy", true).elementByLogicalIndex(index));
+
+    m_prototypes.push_back(prototype);
+}
+
+void LeafInstanceNode::SetInstances(const std::vector<LeafInstance>& instances)
+{
+    MFnArrayAttrsData dataFn;
+    MObject data = dataFn.create();
+
+    MVectorArray positions = dataFn.vectorArray("position");
+    MVectorArray rotations = dataFn.vectorArray("rotation");
+    MVectorArray scales = dataFn.vectorArray("scale");
+    MDoubleArray prototypes = dataFn.doubleArray("objectIndex");
+
+    for(const LeafInstance& instance : instances)
+    {
+        positions.append(MVector(instance.position.x, instance.position.y, instance.position.z));
+        rotations.append(MVector(instance.rotation.x, instance.rotation.y, instance.rotation.z));
+        scales.append(MVector(instance.scale.x, instance.scale.y, instance.scale.z));
+        prototypes.append(instance.prototype);
+    }
+
+    MFnDependencyNode instancerFn(m_instancer);
+    m_dagMod.newPlugValue(instancerFn.findPlug("inputPoints", true), data);
+}
+
+const std::vector<MObject>& LeafInstanceNode::Prototypes() const
+{
+    return m_prototypes;
+}
+
+MObject& LeafInstanceNode::Instancer()
+{
+    return m_instancer;
+}
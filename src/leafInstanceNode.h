@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - leafInstanceNode.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "common.h"
+#include "treeComponents.h"
+#include "leafInstancer.h"
+#include "mayaMesh.h"
+
+#include <vector>
+
+/**
+* Creates the leaf prototypes as hidden meshes and feeds 
+* the leaf transforms to a single Maya instancer node
+*/
+class LeafInstanceNode : public LeafInstanceSink
+{
+public:
+
+    /**
+    * Constructor
+    * @param dagMod The modifier to create the nodes with
+    * @param topology The faces and uvs shared by all prototypes
+    * @param name The name of the instancer
+    * @param parent The node to parent the instancer and prototypes to
+    * @param arrays The arrays to pass the prototype meshes to Maya with
+    */
+    LeafInstanceNode(MDagModifier& dagMod, 
+                     const MeshBuffer& topology, 
+                     const MString& name, 
+                     MObject& parent,
+                     MayaMeshArrays& arrays);
+
+    /**
+    * Creates a hidden mesh for the prototype and connects it to the instancer
+    * @param vertices The local vertices of the prototype
+    */
+    virtual void AddPrototype(const std::vector<Float3>& vertices) override;
+
+    /**
+    * Sets the instancer's points from the leaf transforms
+    * @param instances The transform for each leaf
+    */
+    virtual void SetInstances(const std::vector<LeafInstance>& instances) override;
+
+    /**
+    * @return the prototype meshes
+    */
+    const std::vector<MObject>& Prototypes() const;
+
+    /**
+    * @return the instancer node
+    */
+    MObject& Instancer();
+
+private:
+
+    MDagModifier& m_dagMod;             ///< Modifier to create the nodes with
+    MayaMeshArrays& m_arrays;           ///< Arrays to pass the prototype meshes to Maya with
+    MeshBuffer m_topology;              ///< Faces and uvs shared by all prototypes
+    MString m_name;                     ///< Name of the instancer
+    MObject m_parent;                   ///< Node to parent the instancer and prototypes to
+    MObject m_instancer;                ///< The instancer node
+    std::vector<MObject> m_prototypes;  ///< The prototype meshes
+};
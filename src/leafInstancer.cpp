@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - leafInstancer.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "leafInstancer.h"
+
+#include <algorithm>
+
+namespace
+{
+    const unsigned int BEND_LEVELS = 3;             ///< Bend variations for each bending side of a leaf
+    const float DEGREES = 57.29577951f;             ///< Degrees in a radian
+}
+
+LeafInstancer::LeafInstancer(float width, 
+                             float height, 
+                             float widthVariance, 
+                             float heightVariance, 
+                             float bendAmount) :
+    m_width(width),
+    m_height(height),
+    m_widthVariance(widthVariance),
+    m_heightVariance(heightVariance),
+    m_bendAmount(bendAmount)
+{
+}
+
+int LeafInstancer::VertexCount() const
+{
+    return m_bendAmount != 0.0f ? 6 : 4;
+}
+
+unsigned int LeafInstancer::PrototypeCount() const
+{
+    return m_bendAmount != 0.0f ? BEND_LEVELS * BEND_LEVELS : 1;
+}
+
+unsigned int LeafInstancer::BendLevel(float random) const
+{
+    const float level = (random + 1.0f) * 0.5f * (BEND_LEVELS - 1);
+    return std::min(static_cast<unsigned int>(level + 0.5f), BEND_LEVELS - 1);
+}
+
+float LeafInstancer::BendAmount(unsigned int level) const
+{
+    return m_bendAmount * ((2.0f * level / (BEND_LEVELS - 1)) - 1.0f);
+}
+
+void LeafInstancer::CreatePrototypes(LeafInstanceSink& sink) const
+{
+    // Prototypes are the leaf at its base size, varied by scaling each instance
+    const float width = m_width / 2.0f;
+    std::vector<Float3> vertices(VertexCount());
+    if(m_bendAmount == 0.0f)
+    {
+        vertices[0].Set(-width, 0, 0);
+        vertices[1].Set(width, 0, 0);
+        vertices[2].Set(-width, 0, m_height);
+        vertices[3].Set(width, 0, m_height);
+        sink.AddPrototype(vertices);
+        return;
+    }
+
+    for(unsigned int left = 0; left < BEND_LEVELS; ++left)
+    {
+        for(unsigned int right = 0; right < BEND_LEVELS; ++right)
+        {
+            vertices[0].Set(-width, 0, 0);
+            vertices[1].Set(width, 0, 0);
+            vertices[2].Set(-width, BendAmount(left), m_height / 2.0f);
+            vertices[3].Set(width, BendAmount(right), m_height / 2.0f);
+            vertices[4].Set(-width, 0, m_height);
+            vertices[5].Set(width, 0, m_height);
+            sink.AddPrototype(vertices);
+        }
+    }
+}
+
+LeafInstance LeafInstancer::CreateInstance(const Float3& position,
+                                           const Float3& sectionAxis,
+                                           float sectionRadius,
+                                           const float* random) const
+{
+    LeafInstance instance;
+
+    // Uses the same random values as a baked leaf
+    const float angle = 360.0f * random[0];
+    const float width = m_width + (m_widthVariance * random[1]);
+    const float height = m_height + (m_heightVariance * random[2]);
+    const Matrix rotation = Matrix::CreateRotateArbitrary(sectionAxis, angle / DEGREES);
+
+    // The prototype takes the nearest bend level but the leaf is moved outside
+    // the branch by its own bend so it sits exactly where the baked leaf does
+    instance.prototype = 0;
+    Float3 middle(0.0f, 0.0f, height);
+    if(m_bendAmount != 0.0f)
+    {
+        instance.prototype = (BendLevel(random[3]) * BEND_LEVELS) + BendLevel(random[4]);
+        middle.Set(0.0f, m_bendAmount * random[4], height / 2.0f);
+    }
+
+    // Move roughly outside branch
+    Float3 offset = rotation * middle;
+    offset = (sectionAxis.Cross(offset)).Cross(sectionAxis);
+    offset.Normalize();
+    offset *= sectionRadius / 2.0f;
+
+    instance.position = position + offset;
+    instance.rotation = EulerAngles(rotation);
+    instance.scale.Set(width / m_width, 1.0f, height / m_height);
+    return instance;
+}
+
+Float3 LeafInstancer::EulerAngles(const Matrix& mat)
+{
+    // Matrix is the rotation of X, then Y, then Z
+    const float y = asin(std::max(-1.0f, std::min(1.0f, -mat.m31)));
+    const float x = atan2(mat.m32, mat.m33);
+    const float z = atan2(mat.m21, mat.m11);
+    return Float3(x * DEGREES, y * DEGREES, z * DEGREES);
+}
+
+Matrix LeafInstancer::CreateTransform(const LeafInstance& instance)
+{
+    // Rotation of X, then Y, then Z to match EulerAngles
+    const float cx = cos(instance.rotation.x / DEGREES);
+    const float sx = sin(instance.rotation.x / DEGREES);
+    const float cy = cos(instance.rotation.y / DEGREES);
+    const float sy = sin(instance.rotation.y / DEGREES);
+    const float cz = cos(instance.rotation.z / DEGREES);
+    const float sz = sin(instance.rotation.z / DEGREES);
+    const Float3& scale = instance.scale;
+    const Float3& position = instance.position;
+
+    return Matrix(cy*cz*scale.x, (sx*sy*cz - cx*sz)*scale.y, (cx*sy*cz + sx*sz)*scale.z, position.x,
+                  cy*sz*scale.x, (sx*sy*sz + cx*cz)*scale.y, (cx*sy*sz - sx*cz)*scale.z, position.y,
+                  -sy*scale.x, sx*cy*scale.y, cx*cy*scale.z, position.z);
+}
\ No newline at end of file
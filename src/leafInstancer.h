@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - leafInstancer.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "vector3.h"
+#include "matrix.h"
+
+#include <vector>
+
+/**
+* Transform of a single instanced leaf
+*/
+struct LeafInstance
+{
+    unsigned int prototype;     ///< Index of the leaf prototype to use
+    Float3 position;            ///< World position of the leaf
+    Float3 rotation;            ///< XYZ euler rotation in degrees
+    Float3 scale;               ///< Scale of the prototype
+};
+
+/**
+* Receives the prototypes and transforms for instanced leaves
+*/
+class LeafInstanceSink
+{
+public:
+
+    /**
+    * Destructor
+    */
+    virtual ~LeafInstanceSink() = default;
+
+    /**
+    * Adds a leaf prototype. Prototypes are indexed in the order they are added
+    * @param vertices The local vertices of the prototype
+    */
+    virtual void AddPrototype(const std::vector<Float3>& vertices) = 0;
+
+    /**
+    * Sets the transforms of every instanced leaf
+    * @param instances The transform for each leaf
+    */
+    virtual void SetInstances(const std::vector<LeafInstance>& instances) = 0;
+};
+
+/**
+* Generates a small set of leaf prototypes that cover the bend variations 
+* and the transforms that place a prototype in the place of each leaf
+*/
+class LeafInstancer
+{
+public:
+
+    /**
+    * Constructor
+    * @param width Width of the leaf mesh
+    * @param height Height of the leaf mesh
+    * @param widthVariance Amount to vary the width of the leaf
+    * @param heightVariance Amount to vary the height of the leaf
+    * @param bendAmount Amount to bend the leaf
+    */
+    LeafInstancer(float width, 
+                  float height, 
+                  float widthVariance, 
+                  float heightVariance, 
+                  float bendAmount);
+
+    /**
+    * Sends all prototypes to the sink
+    * @param sink The sink to receive the prototypes
+    */
+    void CreatePrototypes(LeafInstanceSink& sink) const;
+
+    /**
+    * Determines the transform for a leaf
+    * @param position The position of the leaf on the branch
+    * @param sectionAxis Axis for the branch section that leaf lives on
+    * @param sectionRadius Radius for the branch section that leaf lives on
+    * @param random The random values between -1/1 for the leaf
+    * @return the transform of the leaf
+    */
+    LeafInstance CreateInstance(const Float3& position,
+                                const Float3& sectionAxis,
+                                float sectionRadius,
+                                const float* random) const;
+
+    /**
+    * @return the number of vertices of each prototype
+    */
+    int VertexCount() const;
+
+    /**
+    * @return the number of prototypes
+    */
+    unsigned int PrototypeCount() const;
+
+    /**
+    * Converts a rotation matrix into XYZ euler angles
+    * @param mat The rotation matrix
+    * @return The euler angles in degrees
+    */
+    static Float3 EulerAngles(const Matrix& mat);
+
+    /**
+    * Creates the transform that places a prototype in the place of its leaf
+    * @param instance The transform of the leaf
+    * @return the matrix of the scale, rotation and position of the leaf
+    */
+    static Matrix CreateTransform(const LeafInstance& instance);
+
+private:
+
+    /**
+    * Converts a random value into the index of its bend level
+    * @param random The random value between -1/1
+    * @return the bend level
+    */
+    unsigned int BendLevel(float random) const;
+
+    /**
+    * @param level The bend level
+    * @return the amount of bend for the level
+    */
+    float BendAmount(unsigned int level) const;
+
+    float m_width;              ///< Width of the leaf mesh
+    float m_height;             ///< Height of the leaf mesh
+    float m_widthVariance;      ///< Amount to vary the width of the leaf
+    float m_heightVariance;     ///< Amount to vary the height of the leaf
+    float m_bendAmount;         ///< Amount to bend the leaf
+};
@@ -6,6 +6,13 @@
 
 #include "vector3.h"
 
+#include <cstddef>
+
+#if !defined(TREE_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define TREE_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
 /**
 * 4x4 right handed matrix class. 
 * RH Matrix in form of OpenGL: 
@@ -583,7 +590,7 @@ public:
         mat.m21 = (cinv*(vec.x*vec.y)) - (s*vec.z);
         mat.m22 = (cinv*(vec.y*vec.y)) + c;
         mat.m23 = (cinv*(vec.y*vec.z)) + (s*vec.x);
-        mat.m31 = (cinv*(vec.x*vec.y)) + (s*vec.y);
+        mat.m31 = (cinv*(vec.x*vec.z)) + (s*vec.y);
         mat.m32 = (cinv*(vec.y*vec.z)) - (s*vec.x);
         mat.m33 = (cinv*(vec.z*vec.z)) + c;
         (*this) *= mat;
@@ -694,7 +701,7 @@ public:
         mat.m21 = (cinv*(vec.x*vec.y)) - (s*vec.z);
         mat.m22 = (cinv*(vec.y*vec.y)) + c;
         mat.m23 = (cinv*(vec.y*vec.z)) + (s*vec.x);
-        mat.m31 = (cinv*(vec.x*vec.y)) + (s*vec.y);
+        mat.m31 = (cinv*(vec.x*vec.z)) + (s*vec.y);
         mat.m32 = (cinv*(vec.y*vec.z)) - (s*vec.x);
         mat.m33 = (cinv*(vec.z*vec.z)) + c;
         SetPosition(0.0f, 0.0f, 0.0f);
@@ -771,7 +778,7 @@ public:
         mat.m21 = (cinv*(vec.x*vec.y)) - (s*vec.z);
         mat.m22 = (cinv*(vec.y*vec.y)) + c;
         mat.m23 = (cinv*(vec.y*vec.z)) + (s*vec.x);
-        mat.m31 = (cinv*(vec.x*vec.y)) + (s*vec.y);
+        mat.m31 = (cinv*(vec.x*vec.z)) + (s*vec.y);
         mat.m32 = (cinv*(vec.y*vec.z)) - (s*vec.x);
         mat.m33 = (cinv*(vec.z*vec.z)) + c;
         return mat;
@@ -796,4 +803,79 @@ public:
 
         return stream;
     }
-};
\ No newline at end of file
+};
+
+/**
+* Transforms an array of points by a matrix one at a time
+* @param mat The matrix to transform with
+* @param input The points to transform
+* @param output Filled with the transformed points, may be the same as input
+* @param count The number of points
+*/
+inline void TransformPointsScalar(const Matrix& mat, const Float3* input, Float3* output, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        output[i] = mat * input[i];
+    }
+}
+
+/**
+* Transforms an array of points by a matrix. Uses SSE to transform four points
+* at a time when available, matching the scalar path bit for bit unless the
+* compiler fuses the scalar path's multiply-adds
+* @param mat The matrix to transform with
+* @param input The points to transform
+* @param output Filled with the transformed points, may be the same as input
+* @param count The number of points
+*/
+inline void TransformPoints(const Matrix& mat, const Float3* input, Float3* output, size_t count)
+{
+#ifdef TREE_SIMD_SSE
+    static_assert(sizeof(Float3) == sizeof(float) * 3, "Float3 must be tightly packed");
+
+    const __m128 m11 = _mm_set1_ps(mat.m11), m12 = _mm_set1_ps(mat.m12), 
+                 m13 = _mm_set1_ps(mat.m13), m14 = _mm_set1_ps(mat.m14),
+                 m21 = _mm_set1_ps(mat.m21), m22 = _mm_set1_ps(mat.m22), 
+                 m23 = _mm_set1_ps(mat.m23), m24 = _mm_set1_ps(mat.m24),
+                 m31 = _mm_set1_ps(mat.m31), m32 = _mm_set1_ps(mat.m32), 
+                 m33 = _mm_set1_ps(mat.m33), m34 = _mm_set1_ps(mat.m34);
+
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        // Four points are three registers: x0y0z0x1 y1z1x2y2 z2x3y3z3
+        const float* in = &input[i].x;
+        const __m128 a = _mm_loadu_ps(in);
+        const __m128 b = _mm_loadu_ps(in + 4);
+        const __m128 c = _mm_loadu_ps(in + 8);
+
+        // Gather into xxxx yyyy zzzz
+        const __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+        const __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)), 
+                                        _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+        const __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)), c, _MM_SHUFFLE(3,0,2,0));
+
+        // Same order of operations as the scalar path
+        const __m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m11, x), 
+            _mm_mul_ps(m12, y)), _mm_mul_ps(m13, z)), m14);
+        const __m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m21, x), 
+            _mm_mul_ps(m22, y)), _mm_mul_ps(m23, z)), m24);
+        const __m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m31, x), 
+            _mm_mul_ps(m32, y)), _mm_mul_ps(m33, z)), m34);
+
+        // Scatter back into three registers of xyz
+        float* out = &output[i].x;
+        _mm_storeu_ps(out, _mm_shuffle_ps(_mm_shuffle_ps(rx, ry, _MM_SHUFFLE(0,0,0,0)), 
+            _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,2,0)));
+        _mm_storeu_ps(out + 4, _mm_shuffle_ps(_mm_shuffle_ps(ry, rz, _MM_SHUFFLE(1,1,1,1)), 
+            _mm_shuffle_ps(rx, ry, _MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,0,2,0)));
+        _mm_storeu_ps(out + 8, _mm_shuffle_ps(_mm_shuffle_ps(rz, rx, _MM_SHUFFLE(3,3,2,2)), 
+            _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0)));
+    }
+
+    TransformPointsScalar(mat, input + i, output + i, count - i);
+#else
+    TransformPointsScalar(mat, input, output, count);
+#endif
+}
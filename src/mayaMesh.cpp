@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - mayaMesh.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "mayaMesh.h"
+
+namespace
+{
+    /**
+    * Copies values into a Maya array keeping the memory of the array
+    * @param values The values to copy
+    * @param array The array to fill
+    */
+    template<typename T, typename Array> void CopyToArray(const std::vector<T>& values, Array& array)
+    {
+        const unsigned int count = static_cast<unsigned int>(values.size());
+        array.setLength(count);
+        for(unsigned int i = 0; i < count; ++i)
+        {
+            array[i] = values[i];
+        }
+    }
+}
+
+MObject CreateMayaMesh(const MeshBuffer& mesh, MayaMeshArrays& arrays)
+{
+    const unsigned int vertexCount = static_cast<unsigned int>(mesh.vertices.size());
+    arrays.vertices.setLength(vertexCount);
+    for(unsigned int i = 0; i < vertexCount; ++i)
+    {
+        const Float3& vertex = mesh.vertices[i];
+        arrays.vertices.set(i, vertex.x, vertex.y, vertex.z);
+    }
+
+    CopyToArray(mesh.polycounts, arrays.polycounts);
+    CopyToArray(mesh.indices, arrays.indices);
+    CopyToArray(mesh.uvIDs, arrays.uvIDs);
+    CopyToArray(mesh.uCoord, arrays.uCoord);
+    CopyToArray(mesh.vCoord, arrays.vCoord);
+
+    MFnMesh meshfn;
+    MObject node = meshfn.create(arrays.vertices.length(), arrays.polycounts.length(), 
+        arrays.vertices, arrays.polycounts, arrays.indices, arrays.uCoord, arrays.vCoord);
+
+    meshfn.assignUVs(arrays.polycounts, arrays.uvIDs);
+    return node;
+}
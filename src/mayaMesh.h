@@ -0,0 +1,29 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - mayaMesh.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "common.h"
+#include "treeComponents.h"
+
+/**
+* Maya arrays reused to pass the geometry of every mesh to Maya
+*/
+struct MayaMeshArrays
+{
+    MFloatPointArray vertices;  ///< Vertex positions
+    MIntArray polycounts;       ///< Number of vertices for each face
+    MIntArray indices;          ///< Vertex indices for each face
+    MIntArray uvIDs;            ///< UV indices for each face
+    MFloatArray uCoord;         ///< U value for each UV
+    MFloatArray vCoord;         ///< V value for each UV
+};
+
+/**
+* Creates a Maya mesh from geometry
+* @param mesh The geometry of the mesh
+* @param arrays The arrays to fill with the geometry
+* @return the mesh created
+*/
+MObject CreateMayaMesh(const MeshBuffer& mesh, MayaMeshArrays& arrays);
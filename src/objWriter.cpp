@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - objWriter.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "objWriter.h"
+
+ObjWriter::ObjWriter(std::ostream& stream) :
+    m_stream(stream)
+{
+}
+
+void ObjWriter::WriteVertices(const std::string& name, const std::vector<Float3>& vertices)
+{
+    m_stream << "g " << name << "\n";
+    for(const Float3& vertex : vertices)
+    {
+        m_stream << "v " << vertex.x << " " << vertex.y << " " << vertex.z << "\n";
+    }
+}
+
+void ObjWriter::AddMesh(const MeshBuffer& mesh,
+                        const std::string& name,
+                        int,
+                        bool,
+                        const std::vector<int>&)
+{
+    WriteVertices(name, mesh.vertices);
+    for(size_t i = 0; i < mesh.uCoord.size(); ++i)
+    {
+        m_stream << "vt " << mesh.uCoord[i] << " " << mesh.vCoord[i] << "\n";
+    }
+
+    // OBJ indices start at one and are shared by the whole file
+    size_t index = 0;
+    for(int count : mesh.polycounts)
+    {
+        m_stream << "f";
+        for(int i = 0; i < count; ++i, ++index)
+        {
+            m_stream << " " << m_vertexCount + mesh.indices[index] + 1
+                     << "/" << m_uvCount + mesh.uvIDs[index] + 1;
+        }
+        m_stream << "\n";
+    }
+
+    m_vertexCount += static_cast<int>(mesh.vertices.size());
+    m_uvCount += static_cast<int>(mesh.uCoord.size());
+}
+
+void ObjWriter::AddCurve(const std::vector<Float3>& points,
+                         const std::string& name,
+                         int)
+{
+    WriteVertices(name, points);
+
+    m_stream << "l";
+    for(size_t i = 0; i < points.size(); ++i)
+    {
+        m_stream << " " << m_vertexCount + i + 1;
+    }
+    m_stream << "\n";
+
+    m_vertexCount += static_cast<int>(points.size());
+}
+
+LeafInstanceSink& ObjWriter::AddLeafInstancer(const MeshBuffer& topology,
+                                              const std::string& name)
+{
+    m_leafTopology = topology;
+    m_leafName = name;
+    m_prototypes.clear();
+    return *this;
+}
+
+void ObjWriter::AddPrototype(const std::vector<Float3>& vertices)
+{
+    m_prototypes.push_back(vertices);
+}
+
+void ObjWriter::SetInstances(const std::vector<LeafInstance>& instances)
+{
+    // Bake each instance into a single mesh sharing the leaf uvs
+    MeshBuffer mesh;
+    mesh.uCoord = m_leafTopology.uCoord;
+    mesh.vCoord = m_leafTopology.vCoord;
+
+    for(const LeafInstance& instance : instances)
+    {
+        const int offset = static_cast<int>(mesh.vertices.size());
+        const Matrix transform = LeafInstancer::CreateTransform(instance);
+        for(const Float3& vertex : m_prototypes[instance.prototype])
+        {
+            mesh.vertices.push_back(transform * vertex);
+        }
+
+        mesh.polycounts.insert(mesh.polycounts.end(),
+            m_leafTopology.polycounts.begin(), m_leafTopology.polycounts.end());
+
+        mesh.uvIDs.insert(mesh.uvIDs.end(),
+            m_leafTopology.uvIDs.begin(), m_leafTopology.uvIDs.end());
+
+        for(int index : m_leafTopology.indices)
+        {
+            mesh.indices.push_back(offset + index);
+        }
+    }
+
+    AddMesh(mesh, m_leafName, -1, true, std::vector<int>());
+}
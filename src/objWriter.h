@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - objWriter.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeOutput.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+* Writes the geometry of a tree as a Wavefront OBJ. Each mesh and curve becomes
+* a group and instanced leaves are baked into a single mesh
+*/
+class ObjWriter : public TreeOutput, private LeafInstanceSink
+{
+public:
+
+    /**
+    * Constructor
+    * @param stream The stream to write the tree to
+    */
+    explicit ObjWriter(std::ostream& stream);
+
+    virtual void AddMesh(const MeshBuffer& mesh,
+                         const std::string& name,
+                         int layer,
+                         bool leaves,
+                         const std::vector<int>& branchFaces) override;
+
+    virtual void AddCurve(const std::vector<Float3>& points,
+                          const std::string& name,
+                          int layer) override;
+
+    virtual LeafInstanceSink& AddLeafInstancer(const MeshBuffer& topology,
+                                               const std::string& name) override;
+
+private:
+
+    virtual void AddPrototype(const std::vector<Float3>& vertices) override;
+    virtual void SetInstances(const std::vector<LeafInstance>& instances) override;
+
+    /**
+    * Writes the vertex positions of a group
+    * @param name The name of the group
+    * @param vertices The vertex positions
+    */
+    void WriteVertices(const std::string& name, const std::vector<Float3>& vertices);
+
+    std::ostream& m_stream;                         ///< The stream to write the tree to
+    int m_vertexCount = 0;                          ///< Vertices written so far
+    int m_uvCount = 0;                              ///< UVs written so far
+    MeshBuffer m_leafTopology;                      ///< Faces and uvs shared by all leaf prototypes
+    std::string m_leafName;                         ///< The name of the instanced leaves
+    std::vector<std::vector<Float3>> m_prototypes;  ///< Local vertices of each leaf prototype
+};
@@ -46,6 +46,9 @@ MStatus uninitializePlugin(MObject obj)
 {
     MFnPlugin pluginFn(obj);
 
+    // Stop the workers while the plugin can still be safely unloaded
+    TreeGenerator::ReleaseWorkspace();
+
     MStatus success = pluginFn.deregisterCommand(GENERATE_COMMAND);
     if(!success)
     { 
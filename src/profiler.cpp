@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - profiler.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "profiler.h"
+
+#include <algorithm>
+
+Profiler::Scope::Scope(Profiler* profiler, const char* name) :
+    m_profiler(profiler),
+    m_stage(0)
+{
+    if(m_profiler)
+    {
+        m_stage = m_profiler->Begin(name);
+    }
+}
+
+Profiler::Scope::~Scope()
+{
+    if(m_profiler)
+    {
+        m_profiler->End(m_stage);
+    }
+}
+
+Profiler::Profiler() :
+    m_epoch(std::chrono::steady_clock::now())
+{
+}
+
+double Profiler::Now() const
+{
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - m_epoch).count();
+}
+
+size_t Profiler::Begin(const char* name)
+{
+    m_stages.push_back(Stage());
+    m_stages.back().name = name;
+    m_stages.back().start = Now();
+    m_running.push_back(m_stages.size() - 1);
+    return m_stages.size() - 1;
+}
+
+void Profiler::End(size_t stage)
+{
+    m_stages[stage].duration = Now() - m_stages[stage].start;
+    m_running.erase(std::remove(m_running.begin(), m_running.end(), stage), m_running.end());
+}
+
+void Profiler::Count(const char* counter, size_t amount)
+{
+    if(m_running.empty())
+    {
+        return;
+    }
+
+    auto& counts = m_stages[m_running.back()].counts;
+    auto count = std::find_if(counts.begin(), counts.end(),
+        [counter](const std::pair<std::string, size_t>& count)
+    {
+        return count.first == counter;
+    });
+
+    if(count == counts.end())
+    {
+        counts.emplace_back(counter, amount);
+    }
+    else
+    {
+        count->second += amount;
+    }
+}
+
+const std::vector<Profiler::Stage>& Profiler::Stages() const
+{
+    return m_stages;
+}
+
+const Profiler::Stage* Profiler::Find(const char* name) const
+{
+    for(const Stage& stage : m_stages)
+    {
+        if(stage.name == name)
+        {
+            return &stage;
+        }
+    }
+    return nullptr;
+}
+
+size_t Profiler::GetCount(const Stage& stage, const char* counter)
+{
+    for(const auto& count : stage.counts)
+    {
+        if(count.first == counter)
+        {
+            return count.second;
+        }
+    }
+    return 0;
+}
+
+void Profiler::WriteReport(std::ostream& stream) const
+{
+    stream << "{\"stages\": [";
+    for(size_t i = 0; i < m_stages.size(); ++i)
+    {
+        const Stage& stage = m_stages[i];
+        stream << (i == 0 ? "" : ", ") << "{\"name\": \"" << stage.name 
+               << "\", \"start\": " << stage.start << ", \"ms\": " << stage.duration;
+
+        for(const auto& count : stage.counts)
+        {
+            stream << ", \"" << count.first << "\": " << count.second;
+        }
+        stream << "}";
+    }
+    stream << "]}";
+}
+
+void Profiler::WriteTrace(std::ostream& stream) const
+{
+    // Complete events with times in microseconds
+    stream << "{\"traceEvents\": [\n";
+    for(size_t i = 0; i < m_stages.size(); ++i)
+    {
+        const Stage& stage = m_stages[i];
+        stream << "  {\"name\": \"" << stage.name << "\", \"cat\": \"tree\", \"ph\": \"X\", "
+               << "\"pid\": 1, \"tid\": 1, \"ts\": " << stage.start * 1000.0 
+               << ", \"dur\": " << stage.duration * 1000.0 << ", \"args\": {";
+
+        for(size_t j = 0; j < stage.counts.size(); ++j)
+        {
+            stream << (j == 0 ? "" : ", ") << "\"" << stage.counts[j].first 
+                   << "\": " << stage.counts[j].second;
+        }
+        stream << "}}" << (i + 1 < m_stages.size() ? ",\n" : "\n");
+    }
+    stream << "]}" << std::endl;
+}
+
+void Profiler::Clear()
+{
+    m_stages.clear();
+    m_running.clear();
+    m_epoch = std::chrono::steady_clock::now();
+}
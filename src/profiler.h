@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - profiler.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+* Records the wall time and counts of each stage of generating a tree.
+* Stages are timed from the thread generating the tree only
+*/
+class Profiler
+{
+public:
+
+    /**
+    * A single timed stage
+    */
+    struct Stage
+    {
+        std::string name;       ///< Name of the stage
+        double start = 0.0;     ///< Milliseconds from the creation of the profiler the stage began
+        double duration = 0.0;  ///< Milliseconds the stage took
+        std::vector<std::pair<std::string, size_t>> counts; ///< Amounts of work done in the stage
+    };
+
+    /**
+    * Times a stage for the lifetime of the scope
+    */
+    class Scope
+    {
+    public:
+
+        /**
+        * Constructor, begins the stage
+        * @param profiler The profiler to record to or null if not profiling
+        * @param name The name of the stage
+        */
+        Scope(Profiler* profiler, const char* name);
+
+        /**
+        * Destructor, ends the stage
+        */
+        ~Scope();
+
+    private:
+
+        /**
+        * Prevent copying
+        */
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        Profiler* m_profiler;   ///< The profiler to record to or null if not profiling
+        size_t m_stage;         ///< Index of the stage being timed
+    };
+
+    /**
+    * Constructor
+    */
+    Profiler();
+
+    /**
+    * Adds to a count of the innermost running stage
+    * @param counter The name of the count
+    * @param amount The amount to add
+    */
+    void Count(const char* counter, size_t amount);
+
+    /**
+    * @return all stages in the order they began
+    */
+    const std::vector<Stage>& Stages() const;
+
+    /**
+    * @param name The name of the stage
+    * @return the first stage with the name or null if it did not run
+    */
+    const Stage* Find(const char* name) const;
+
+    /**
+    * @param stage The stage to search
+    * @param counter The name of the count
+    * @return the count or zero if not recorded
+    */
+    static size_t GetCount(const Stage& stage, const char* counter);
+
+    /**
+    * Writes the time and counts of each stage as JSON
+    * @param stream The stream to write to
+    */
+    void WriteReport(std::ostream& stream) const;
+
+    /**
+    * Writes each stage as a Chrome trace event to view in chrome://tracing
+    * @param stream The stream to write to
+    */
+    void WriteTrace(std::ostream& stream) const;
+
+    /**
+    * Removes all recorded stages
+    */
+    void Clear();
+
+private:
+
+    /**
+    * @return milliseconds since the creation of the profiler
+    */
+    double Now() const;
+
+    /**
+    * Begins a stage
+    * @param name The name of the stage
+    * @return the index of the stage
+    */
+    size_t Begin(const char* name);
+
+    /**
+    * Ends a stage
+    * @param stage The index of the stage
+    */
+    void End(size_t stage);
+
+    std::chrono::steady_clock::time_point m_epoch;  ///< Time the profiler was created
+    std::vector<Stage> m_stages;                    ///< All stages in the order they began
+    std::vector<size_t> m_running;                  ///< Indices of the stages still running
+};
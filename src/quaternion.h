@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - quaternion.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "vector3.h"
+#include "matrix.h"
+
+/**
+* Unit quaternion for holding an orientation. Local rotations
+* follow the same handedness as the local rotations of Matrix
+*/
+class Quaternion
+{
+public:
+
+    float w, x, y, z; ///< Quaternion components
+
+    /**
+    * Constructor, defaults to no rotation
+    * @param W/X/Y/Z The components of the quaternion
+    */
+    explicit Quaternion(float W = 1.0f, float X = 0.0f, float Y = 0.0f, float Z = 0.0f) :
+        w(W),
+        x(X),
+        y(Y),
+        z(Z)
+    {
+    }
+
+    /**
+    * Quaternion Multiplication: [this][quat]
+    * @param quat The quaternion to multiply with
+    * @return The rotation of quat followed by this
+    */
+    Quaternion operator*(const Quaternion& quat) const
+    {
+        return Quaternion((w*quat.w)-(x*quat.x)-(y*quat.y)-(z*quat.z),
+                          (w*quat.x)+(x*quat.w)+(y*quat.z)-(z*quat.y),
+                          (w*quat.y)-(x*quat.z)+(y*quat.w)+(z*quat.x),
+                          (w*quat.z)+(x*quat.y)-(y*quat.x)+(z*quat.w));
+    }
+
+    /**
+    * Rotates a vector by the quaternion
+    * @param vec The vector to rotate
+    * @return The rotated vector
+    */
+    Float3 Rotate(const Float3& vec) const
+    {
+        const Float3 axis(x, y, z);
+        const Float3 t = axis.Cross(vec) * 2.0f;
+        return vec + (t * w) + axis.Cross(t);
+    }
+
+    /**
+    * @return The forward axis of the orientation
+    */
+    Float3 Forward() const
+    {
+        return Float3(2.0f*((x*z)+(w*y)),
+                      2.0f*((y*z)-(w*x)),
+                      1.0f-(2.0f*((x*x)+(y*y))));
+    }
+
+    /**
+    * Rescales the quaternion to unit length to remove any drift
+    */
+    void Normalize()
+    {
+        const float length = sqrt((w*w)+(x*x)+(y*y)+(z*z));
+        if(length != 0.0f)
+        {
+            w /= length;
+            x /= length;
+            y /= length;
+            z /= length;
+        }
+    }
+
+    /**
+    * Rotates around the local X axis
+    * @param radians The angle in radians to rotate
+    */
+    void RotateXLocal(float radians)
+    {
+        const float c = cos(radians * 0.5f);
+        const float s = -sin(radians * 0.5f);
+        Set((w*c)-(x*s), (x*c)+(w*s), (y*c)+(z*s), (z*c)-(y*s));
+    }
+
+    /**
+    * Rotates around the local Y axis
+    * @param radians The angle in radians to rotate
+    */
+    void RotateYLocal(float radians)
+    {
+        const float c = cos(radians * 0.5f);
+        const float s = -sin(radians * 0.5f);
+        Set((w*c)-(y*s), (x*c)-(z*s), (y*c)+(w*s), (z*c)+(x*s));
+    }
+
+    /**
+    * Rotates around the local Z axis
+    * @param radians The angle in radians to rotate
+    */
+    void RotateZLocal(float radians)
+    {
+        const float c = cos(radians * 0.5f);
+        const float s = -sin(radians * 0.5f);
+        Set((w*c)-(z*s), (x*c)+(y*s), (y*c)-(x*s), (z*c)+(w*s));
+    }
+
+    /**
+    * Sets all components
+    * @param W/X/Y/Z The components of the quaternion
+    */
+    void Set(float W, float X, float Y, float Z)
+    {
+        w = W;
+        x = X;
+        y = Y;
+        z = Z;
+    }
+
+    /**
+    * Creates a matrix holding the orientation
+    * @param position The position for the matrix
+    * @return The matrix for the orientation
+    */
+    Matrix ToMatrix(const Float3& position = Float3()) const
+    {
+        return Matrix(1.0f-(2.0f*((y*y)+(z*z))), 2.0f*((x*y)-(w*z)), 2.0f*((x*z)+(w*y)), position.x,
+                      2.0f*((x*y)+(w*z)), 1.0f-(2.0f*((x*x)+(z*z))), 2.0f*((y*z)-(w*x)), position.y,
+                      2.0f*((x*z)-(w*y)), 2.0f*((y*z)+(w*x)), 1.0f-(2.0f*((x*x)+(y*y))), position.z);
+    }
+
+    /**
+    * Creates a rotation of the global X axis with the handedness of Matrix::CreateRotateX
+    * @param radians The angle in radians to rotate
+    * @return The rotation quaternion
+    */
+    static Quaternion CreateRotateX(float radians)
+    {
+        return Quaternion(cos(radians * 0.5f), -sin(radians * 0.5f), 0.0f, 0.0f);
+    }
+
+    /**
+    * Creates a rotation of the global Y axis with the handedness of Matrix::CreateRotateY
+    * @param radians The angle in radians to rotate
+    * @return The rotation quaternion
+    */
+    static Quaternion CreateRotateY(float radians)
+    {
+        return Quaternion(cos(radians * 0.5f), 0.0f, -sin(radians * 0.5f), 0.0f);
+    }
+
+    /**
+    * Creates a rotation of the global Z axis with the handedness of Matrix::CreateRotateZ
+    * @param radians The angle in radians to rotate
+    * @return The rotation quaternion
+    */
+    static Quaternion CreateRotateZ(float radians)
+    {
+        return Quaternion(cos(radians * 0.5f), 0.0f, 0.0f, -sin(radians * 0.5f));
+    }
+};
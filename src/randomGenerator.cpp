@@ -3,11 +3,32 @@
 ////////////////////////////////////////////////////////////////////////////////////////
 
 #include "randomGenerator.h"
-#include "common.h"
 
 #include <time.h>
+#include <algorithm>
 
-std::default_random_engine Random::sm_generator;
+namespace
+{
+    const std::uint32_t PHILOX_M0 = 0xD2511F53;     ///< Philox multiplier for the first word pair
+    const std::uint32_t PHILOX_M1 = 0xCD9E8D57;     ///< Philox multiplier for the second word pair
+    const std::uint32_t PHILOX_W0 = 0x9E3779B9;     ///< Philox key increment for the first word
+    const std::uint32_t PHILOX_W1 = 0xBB67AE85;     ///< Philox key increment for the second word
+    const int PHILOX_ROUNDS = 10;                   ///< Rounds required for the full Philox4x32 quality
+    const float SIGNED_SCALE = 1.0f / 2147483648.0f; ///< Scales a signed 32 bit value to -1/1
+
+    /**
+    * Mixes a parent stream id with a child id
+    */
+    std::uint64_t MixStream(std::uint64_t parent, std::uint64_t id)
+    {
+        std::uint64_t z = parent + 0x9E3779B97F4A7C15ull * (id + 1);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+}
+
+RandomStream Random::sm_generator;
 
 void Random::Initialise()
 {
@@ -16,24 +37,138 @@ void Random::Initialise()
 
 void Random::RandomizeSeed()
 {
-    const auto seed = static_cast<unsigned long>(time(0));
-    sm_generator.seed(seed);
+    Seed(static_cast<unsigned int>(time(0)));
+}
+
+void Random::Seed(unsigned int seed)
+{
+    sm_generator = RandomStream(seed);
 }
 
 int Random::Generate(int min, int max)
 {
-    std::uniform_int_distribution<int> distribution(min, max);
-    return distribution(sm_generator);
+    return sm_generator.Generate(min, max);
 }
 
 float Random::Generate(float min, float max)
 {
-    std::uniform_real_distribution<float> distribution(min, max);
-    return distribution(sm_generator);
+    return sm_generator.Generate(min, max);
 }
 
 double Random::Generate(double min, double max)
 {
-    std::uniform_real_distribution<double> distribution(min, max);
-    return distribution(sm_generator);
-}
\ No newline at end of file
+    return sm_generator.Generate(min, max);
+}
+
+RandomStream::RandomStream(unsigned int seed, std::uint64_t id) :
+    m_seed(seed),
+    m_id(id)
+{
+}
+
+RandomStream RandomStream::Split(std::uint64_t id) const
+{
+    return RandomStream(m_seed, MixStream(m_id, id));
+}
+
+void RandomStream::GenerateBatch(std::uint32_t* values)
+{
+    std::uint32_t c0[BATCH_BLOCKS], c1[BATCH_BLOCKS], c2[BATCH_BLOCKS], c3[BATCH_BLOCKS];
+    for(unsigned int i = 0; i < BATCH_BLOCKS; ++i)
+    {
+        const std::uint64_t counter = m_counter + i;
+        c0[i] = static_cast<std::uint32_t>(counter);
+        c1[i] = static_cast<std::uint32_t>(counter >> 32);
+        c2[i] = static_cast<std::uint32_t>(m_id);
+        c3[i] = static_cast<std::uint32_t>(m_id >> 32);
+    }
+    m_counter += BATCH_BLOCKS;
+
+    std::uint32_t k0 = m_seed;
+    std::uint32_t k1 = 0;
+    for(int round = 0; round < PHILOX_ROUNDS; ++round)
+    {
+        for(unsigned int i = 0; i < BATCH_BLOCKS; ++i)
+        {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(PHILOX_M0) * c0[i];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(PHILOX_M1) * c2[i];
+
+            c0[i] = static_cast<std::uint32_t>(p1 >> 32) ^ c1[i] ^ k0;
+            c2[i] = static_cast<std::uint32_t>(p0 >> 32) ^ c3[i] ^ k1;
+            c1[i] = static_cast<std::uint32_t>(p1);
+            c3[i] = static_cast<std::uint32_t>(p0);
+        }
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    for(unsigned int i = 0; i < BATCH_BLOCKS; ++i)
+    {
+        values[i * BLOCK_SIZE] = c0[i];
+        values[i * BLOCK_SIZE + 1] = c1[i];
+        values[i * BLOCK_SIZE + 2] = c2[i];
+        values[i * BLOCK_SIZE + 3] = c3[i];
+    }
+}
+
+std::uint32_t RandomStream::Next()
+{
+    if(m_bitsUsed == BATCH_SIZE)
+    {
+        GenerateBatch(m_bits);
+        m_bitsUsed = 0;
+    }
+    return m_bits[m_bitsUsed++];
+}
+
+float RandomStream::Signed()
+{
+    if(m_signedUsed == BATCH_SIZE)
+    {
+        Fill(m_signed, BATCH_SIZE);
+        m_signedUsed = 0;
+    }
+    return m_signed[m_signedUsed++];
+}
+
+void RandomStream::Fill(float* values, size_t count)
+{
+    std::uint32_t bits[BATCH_SIZE];
+    for(size_t i = 0; i < count; i += BATCH_SIZE)
+    {
+        GenerateBatch(bits);
+
+        // Reinterpreting as signed gives an even spread across -1/1
+        const size_t batch = std::min(count - i, size_t(BATCH_SIZE));
+        for(size_t j = 0; j < batch; ++j)
+        {
+            values[i + j] = static_cast<std::int32_t>(bits[j]) * SIGNED_SCALE;
+        }
+    }
+}
+
+int RandomStream::Generate(int min, int max)
+{
+    // Scale into the range rather than using modulo to keep the low bits unbiased
+    const std::uint64_t range = static_cast<std::uint64_t>(
+        static_cast<std::int64_t>(max) - static_cast<std::int64_t>(min)) + 1;
+    const std::uint64_t value = (static_cast<std::uint64_t>(Next()) * range) >> 32;
+    return static_cast<int>(static_cast<std::int64_t>(min) + static_cast<std::int64_t>(value));
+}
+
+float RandomStream::Generate(float min, float max)
+{
+    // Top 24 bits fill the float's mantissa
+    const float unit = (Next() >> 8) * (1.0f / 16777216.0f);
+    return min + (max - min) * unit;
+}
+
+double RandomStream::Generate(double min, double max)
+{
+    // Top 53 bits fill the double's mantissa
+    const std::uint64_t high = Next();
+    const std::uint64_t bits = (high << 21) | (Next() >> 11);
+    const double unit = bits * (1.0 / 9007199254740992.0);
+    return min + (max - min) * unit;
+}
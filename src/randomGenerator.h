@@ -4,10 +4,88 @@
 
 #pragma once
 
-#include <random>
+#include <cstdint>
+#include <cstddef>
 
 /**
-* Utility class to get a random value
+* Counter based random generator. Each value is a Philox4x32-10 hash of
+* the seed, stream id and position in the stream so streams can be split
+* and read from any thread without depending on evaluation order
+*/
+class RandomStream
+{
+public:
+
+    /**
+    * Constructor
+    * @param seed The user seed for the stream
+    * @param id The identifier of the stream
+    */
+    explicit RandomStream(unsigned int seed = 0, std::uint64_t id = 0);
+
+    /**
+    * Creates a new stream with the same seed
+    * @param id The identifier of the new stream, unique for this parent
+    * @return the new stream
+    */
+    RandomStream Split(std::uint64_t id) const;
+
+    /**
+    * @return a random int between min/max
+    */
+    int Generate(int min, int max);
+
+    /**
+    * @return a random float between min/max
+    */
+    float Generate(float min, float max);
+
+    /**
+    * @return a random double between min/max
+    */
+    double Generate(double min, double max);
+
+    /**
+    * @return the next 32 random bits in the stream
+    */
+    std::uint32_t Next();
+
+    /**
+    * @return a random float between -1/1 read from a buffer filled in batches
+    */
+    float Signed();
+
+    /**
+    * Fills an array with random floats between -1/1
+    * @param values The array to fill
+    * @param count The number of values to generate
+    */
+    void Fill(float* values, size_t count);
+
+    static const unsigned int BLOCK_SIZE = 4;       ///< Number of values generated by each block
+    static const unsigned int BATCH_BLOCKS = 4;     ///< Number of blocks generated side by side
+    static const unsigned int BATCH_SIZE = BLOCK_SIZE * BATCH_BLOCKS; ///< Number of values in a batch
+
+private:
+
+    /**
+    * Hashes consecutive positions in the stream into blocks of random values.
+    * The blocks are processed together so the rounds can be vectorised
+    * @param values Filled with BATCH_SIZE values
+    */
+    void GenerateBatch(std::uint32_t* values);
+
+    unsigned int m_seed;                    ///< The user seed for the stream
+    std::uint64_t m_id;                     ///< The identifier of the stream
+    std::uint64_t m_counter = 0;            ///< The position of the next block in the stream
+    std::uint32_t m_bits[BATCH_SIZE];       ///< Values of the current batch for Next
+    unsigned int m_bitsUsed = BATCH_SIZE;   ///< Number of values read from the bits batch
+    float m_signed[BATCH_SIZE];             ///< Values of the current batch for Signed
+    unsigned int m_signedUsed = BATCH_SIZE; ///< Number of values read from the signed batch
+};
+
+/**
+* Utility class to get a random value. Only to be used from the main thread
 */
 class Random
 {
@@ -23,6 +101,12 @@ public:
     */
     static void RandomizeSeed();
 
+    /**
+    * Changes the seed to a set value
+    * @param seed The seed to use
+    */
+    static void Seed(unsigned int seed);
+
     /**
     * @return a random int between min/max
     */
@@ -40,5 +124,5 @@ public:
 
 private:
 
-    static std::default_random_engine sm_generator;
-};
\ No newline at end of file
+    static RandomStream sm_generator;
+};
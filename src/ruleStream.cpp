@@ -0,0 +1,225 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - ruleStream.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ruleStream.h"
+#include "ruleSystem.h"
+
+RuleReader::RuleReader(const std::string& rule, bool jumpBranches) :
+    m_rule(rule),
+    m_end(rule.size())
+{
+    if(jumpBranches)
+    {
+        m_jumps = std::make_shared<std::vector<Jump>>();
+        std::vector<Jump>& jumps = *m_jumps;
+
+        std::vector<size_t> open;
+        size_t bracket = 0;
+        for(size_t i = 0; i < rule.size(); ++i)
+        {
+            if(rule[i] == '[')
+            {
+                open.push_back(bracket++);
+                jumps.push_back(Jump());
+            }
+            else if(rule[i] == ']' && !open.empty())
+            {
+                jumps[open.back()].position = i + 1;
+                jumps[open.back()].bracket = bracket;
+                open.pop_back();
+            }
+        }
+
+        // Unmatched branches continue to the end of the rule
+        for(size_t unmatched : open)
+        {
+            jumps[unmatched].position = rule.size();
+            jumps[unmatched].bracket = bracket;
+        }
+    }
+}
+
+bool RuleReader::Next(char& symbol)
+{
+    if(m_position < m_end)
+    {
+        symbol = m_rule[m_position++];
+        if(symbol == '[')
+        {
+            ++m_bracket;
+        }
+        return true;
+    }
+    return false;
+}
+
+void RuleReader::SkipBranch()
+{
+    if(m_jumps)
+    {
+        const Jump& jump = (*m_jumps)[m_bracket - 1];
+        m_position = jump.position;
+        m_bracket = jump.bracket;
+        return;
+    }
+
+    // Remove all symbols up until corresponding ]
+    int searchnumber = 1;
+    while(m_position < m_end)
+    {
+        const char symbol = m_rule[m_position++];
+        if(symbol == '[')
+        {
+            searchnumber++;
+        }
+        if(symbol == ']')
+        {
+            searchnumber--;
+        }
+        if(searchnumber == 0)
+        {
+            break;
+        }
+    }
+}
+
+size_t RuleReader::BranchLength() const
+{
+    return (*m_jumps)[m_bracket - 1].position - m_position;
+}
+
+RuleReader RuleReader::SplitBranch()
+{
+    RuleReader branch(*this);
+    branch.m_begin = m_position;
+    branch.m_end = (*m_jumps)[m_bracket - 1].position;
+
+    SkipBranch();
+    return branch;
+}
+
+size_t RuleReader::Size() const
+{
+    return m_end - m_begin;
+}
+
+RuleStream::RuleStream(const RuleSystem& rules,
+                       const std::string& prerule,
+                       const std::string& axiom,
+                       const std::string& postrule,
+                       unsigned int iterations) :
+    m_rules(rules),
+    m_prerule(prerule),
+    m_axiom(axiom),
+    m_postrule(postrule),
+    m_iterations(iterations),
+    m_indices(iterations + 1, 0)
+{
+    m_size = prerule.size() + postrule.size() +
+        static_cast<size_t>(rules.ExpectedLength(axiom, iterations));
+
+    m_frames.reserve(iterations + 1);
+    m_frames.push_back(Frame{ m_axiom.c_str(), m_axiom.size(), 0, 0, nullptr });
+}
+
+bool RuleStream::Next(char& symbol)
+{
+    switch(m_stage)
+    {
+    case PRERULE:
+        if(m_position < m_prerule.size())
+        {
+            symbol = m_prerule[m_position++];
+            return true;
+        }
+        m_stage = DERIVED;
+        // fall through
+    case DERIVED:
+        if(NextDerived(symbol))
+        {
+            return true;
+        }
+        m_stage = POSTRULE;
+        m_position = 0;
+        // fall through
+    case POSTRULE:
+        if(m_position < m_postrule.size())
+        {
+            symbol = m_postrule[m_position++];
+            return true;
+        }
+        m_stage = FINISHED;
+        // fall through
+    case FINISHED:
+    default:
+        return false;
+    }
+}
+
+bool RuleStream::NextDerived(char& symbol)
+{
+    while(!m_frames.empty())
+    {
+        const unsigned int generation = static_cast<unsigned int>(m_frames.size() - 1);
+        Frame& frame = m_frames.back();
+        if(frame.position == frame.length)
+        {
+            m_frames.pop_back();
+            continue;
+        }
+
+        // Skip branches that die while being derived
+        if(frame.jumps != nullptr && frame.jumps[frame.position] != 0 &&
+           m_rules.BranchDies(generation - 1, frame.source, frame.position))
+        {
+            frame.position = frame.jumps[frame.position];
+            continue;
+        }
+
+        // Symbols are visited in order at every iteration so the
+        // index matches the position the full rewrite would give
+        const char& current = frame.symbols[frame.position++];
+        const size_t index = m_indices[generation]++;
+        if(generation == m_iterations)
+        {
+            symbol = current;
+            return true;
+        }
+
+        const RuleSystem::Replacement replacement = m_rules.Replace(generation, index, current);
+        if(replacement.length > 0)
+        {
+            m_frames.push_back(Frame{ replacement.symbols, 
+                replacement.length, 0, index, replacement.jumps });
+        }
+    }
+    return false;
+}
+
+void RuleStream::SkipBranch()
+{
+    // Remove all symbols up until corresponding ]
+    int searchnumber = 1;
+    char symbol = 0;
+    while(Next(symbol))
+    {
+        if(symbol == '[')
+        {
+            searchnumber++;
+        }
+        if(symbol == ']')
+        {
+            searchnumber--;
+        }
+        if(searchnumber == 0)
+        {
+            break;
+        }
+    }
+}
+
+size_t RuleStream::Size() const
+{
+    return m_size;
+}
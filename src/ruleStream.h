@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - ruleStream.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+class RuleSystem;
+
+/**
+* Reads symbols from a rule string that has already been derived
+*/
+class RuleReader
+{
+public:
+
+    /**
+    * Constructor
+    * @param rule The derived rule string to read
+    * @param jumpBranches Whether to index matching brackets so branches are skipped in one step
+    */
+    RuleReader(const std::string& rule, bool jumpBranches);
+
+    /**
+    * Gets the next symbol
+    * @param symbol Filled with the next symbol
+    * @return whether there was a symbol to read
+    */
+    bool Next(char& symbol);
+
+    /**
+    * Skips all symbols up to and including the ] matching the last read [
+    */
+    void SkipBranch();
+
+    /**
+    * @return the number of symbols up to and including the ] matching the last read [
+    * @note requires branches to be indexed
+    */
+    size_t BranchLength() const;
+
+    /**
+    * Splits off the symbols of the branch opened by the last read [ into
+    * a new reader and skips past them in this reader
+    * @note requires branches to be indexed
+    * @return a reader for the symbols up to and including the matching ]
+    */
+    RuleReader SplitBranch();
+
+    /**
+    * @return the total number of symbols
+    */
+    size_t Size() const;
+
+private:
+
+    /**
+    * Where to continue reading when skipping a branch
+    */
+    struct Jump
+    {
+        size_t position;        ///< Position after the branch's matching ]
+        size_t bracket;         ///< Number of [ before that position
+    };
+
+    const std::string& m_rule;                      ///< The derived rule string
+    size_t m_begin = 0;                             ///< Position of the first symbol to read
+    size_t m_end = 0;                               ///< Position after the last symbol to read
+    size_t m_position = 0;                          ///< Position of the next symbol to read
+    size_t m_bracket = 0;                           ///< Number of [ read so far
+    std::shared_ptr<std::vector<Jump>> m_jumps;     ///< Where each [ in order jumps to when skipped
+};
+
+/**
+* Derives the rule depth first as symbols are requested. Only the
+* production being expanded at each iteration is held in memory
+*/
+class RuleStream
+{
+public:
+
+    /**
+    * Constructor
+    * @param rules The productions to derive with
+    * @param prerule The symbols to read before the derived rule
+    * @param axiom The symbols to start deriving from
+    * @param postrule The symbols to read after the derived rule
+    * @param iterations The number of rewrite iterations
+    */
+    RuleStream(const RuleSystem& rules,
+               const std::string& prerule,
+               const std::string& axiom,
+               const std::string& postrule,
+               unsigned int iterations);
+
+    /**
+    * Gets the next symbol
+    * @param symbol Filled with the next symbol
+    * @return whether there was a symbol to read
+    */
+    bool Next(char& symbol);
+
+    /**
+    * Skips all symbols up to and including the ] matching the last read [
+    */
+    void SkipBranch();
+
+    /**
+    * @return the expected total number of symbols
+    */
+    size_t Size() const;
+
+private:
+
+    /**
+    * Prevent copying as frames point into the stream's own strings
+    */
+    RuleStream(const RuleStream&) = delete;
+    RuleStream& operator=(const RuleStream&) = delete;
+
+    /**
+    * Symbols at one iteration currently being expanded
+    */
+    struct Frame
+    {
+        const char* symbols;    ///< The production being read
+        size_t length;          ///< The number of symbols in the production
+        size_t position;        ///< Position of the next symbol to read
+        size_t source;          ///< Index of the symbol the production replaced
+        const size_t* jumps;    ///< Matching brackets if branches can die while derived
+    };
+
+    /**
+    * Parts of the rule that are read in order
+    */
+    enum Stage
+    {
+        PRERULE,
+        DERIVED,
+        POSTRULE,
+        FINISHED
+    };
+
+    /**
+    * Expands the derived rule until a final symbol is found
+    * @param symbol Filled with the next symbol
+    * @return whether there was a symbol to read
+    */
+    bool NextDerived(char& symbol);
+
+    const RuleSystem& m_rules;          ///< The productions to derive with
+    std::string m_prerule;              ///< The symbols to read before the derived rule
+    std::string m_axiom;                ///< The symbols to start deriving from
+    std::string m_postrule;             ///< The symbols to read after the derived rule
+    unsigned int m_iterations;          ///< The number of rewrite iterations
+    size_t m_size;                      ///< The expected total number of symbols
+    Stage m_stage = PRERULE;            ///< The part of the rule being read
+    size_t m_position = 0;              ///< Position in the prerule or postrule
+    std::vector<Frame> m_frames;        ///< The production being expanded at each iteration
+    std::vector<size_t> m_indices;      ///< Index of the next symbol in each iteration's string
+};
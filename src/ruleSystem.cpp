@@ -0,0 +1,221 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - ruleSystem.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ruleSystem.h"
+#include "threadPool.h"
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    const unsigned int ALWAYS = 100;           ///< Chance for a production that is always used
+}
+
+RuleSystem::RuleSystem()
+{
+}
+
+void RuleSystem::Clear()
+{
+    m_table.fill(Production());
+    m_branchDeath = 0;
+}
+
+void RuleSystem::AddRule(char symbol, const std::string& production, unsigned int chance)
+{
+    Production& entry = m_table[static_cast<unsigned char>(symbol)];
+    if(!entry.isRule)
+    {
+        entry.symbols = production;
+        entry.chance = chance;
+        entry.isRule = true;
+
+        // Match the brackets that open and close within the production
+        std::vector<size_t> open;
+        entry.jumps.assign(production.size(), 0);
+        for(size_t i = 0; i < production.size(); ++i)
+        {
+            if(production[i] == '[')
+            {
+                open.push_back(i);
+            }
+            else if(production[i] == ']' && !open.empty())
+            {
+                entry.jumps[open.back()] = i + 1;
+                entry.hasBranches = true;
+                open.pop_back();
+            }
+        }
+    }
+}
+
+void RuleSystem::SetSeed(unsigned int seed)
+{
+    m_seed = seed;
+}
+
+void RuleSystem::SetBranchDeath(unsigned int probability)
+{
+    m_branchDeath = probability;
+}
+
+int RuleSystem::Roll(unsigned int generation, size_t index, size_t salt) const
+{
+    std::uint64_t z = (static_cast<std::uint64_t>(m_seed) << 32)
+        + (0x9E3779B97F4A7C15ull * (generation + 1))
+        + (0xD1B54A32D192ED03ull * salt) + index;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z = z ^ (z >> 31);
+    return static_cast<int>(z % (ALWAYS + 1));
+}
+
+RuleSystem::Replacement RuleSystem::Replace(unsigned int generation,
+                                            size_t index,
+                                            const char& symbol) const
+{
+    Replacement replacement;
+    const Production& production = m_table[static_cast<unsigned char>(symbol)];
+    if(!production.isRule)
+    {
+        // No rule found, leave in string
+        replacement.symbols = &symbol;
+        replacement.length = 1;
+    }
+    else if(production.chance >= ALWAYS || (production.chance != 0 &&
+        Roll(generation, index, 0) <= static_cast<int>(production.chance)))
+    {
+        replacement.symbols = production.symbols.c_str();
+        replacement.length = production.symbols.size();
+        if(m_branchDeath > 0 && production.hasBranches)
+        {
+            replacement.jumps = &production.jumps[0];
+        }
+    }
+    return replacement;
+}
+
+bool RuleSystem::BranchDies(unsigned int generation, size_t index, size_t offset) const
+{
+    return Roll(generation, index, offset + 1) < static_cast<int>(m_branchDeath);
+}
+
+size_t RuleSystem::Emit(unsigned int generation,
+                        size_t index,
+                        const Replacement& replacement,
+                        char* output) const
+{
+    if(replacement.jumps == nullptr)
+    {
+        if(output != nullptr && replacement.length > 0)
+        {
+            memcpy(output, replacement.symbols, replacement.length);
+        }
+        return replacement.length;
+    }
+
+    // Copy the replacement without any branches that die
+    size_t count = 0;
+    size_t i = 0;
+    while(i < replacement.length)
+    {
+        if(replacement.jumps[i] != 0 && BranchDies(generation, index, i))
+        {
+            i = replacement.jumps[i];
+            continue;
+        }
+
+        if(output != nullptr)
+        {
+            output[count] = replacement.symbols[i];
+        }
+        ++count;
+        ++i;
+    }
+    return count;
+}
+
+double RuleSystem::ExpectedLength(const std::string& axiom, unsigned int iterations) const
+{
+    // Length of each symbol once expanded through the remaining iterations
+    std::vector<double> lengths(m_table.size(), 1.0);
+    std::vector<double> next(m_table.size(), 1.0);
+    for(unsigned int i = 0; i < iterations; ++i)
+    {
+        for(size_t symbol = 0; symbol < m_table.size(); ++symbol)
+        {
+            const Production& production = m_table[symbol];
+            if(production.isRule)
+            {
+                double length = 0.0;
+                for(const char& c : production.symbols)
+                {
+                    length += lengths[static_cast<unsigned char>(c)];
+                }
+                next[symbol] = length * std::min(production.chance, ALWAYS) / ALWAYS;
+            }
+        }
+        lengths.swap(next);
+    }
+
+    double length = 0.0;
+    for(const char& c : axiom)
+    {
+        length += lengths[static_cast<unsigned char>(c)];
+    }
+    return length;
+}
+
+size_t RuleSystem::RewriteChunk(const std::string& source,
+                                size_t begin,
+                                size_t end,
+                                unsigned int generation,
+                                char* output) const
+{
+    size_t count = 0;
+    for(size_t i = begin; i < end; ++i)
+    {
+        count += Emit(generation, i, Replace(generation, i, source[i]),
+            output != nullptr ? output + count : nullptr);
+    }
+    return count;
+}
+
+void RuleSystem::Rewrite(const std::string& source,
+                         std::string& result,
+                         unsigned int generation,
+                         ThreadPool& pool) const
+{
+    // Count the size of each chunk's output
+    std::vector<size_t> offsets(pool.ChunkCount(source.size(), MIN_REWRITE_CHUNK) + 1, 0);
+    const size_t chunks = pool.ParallelFor(source.size(), MIN_REWRITE_CHUNK,
+        [&](size_t chunk, size_t begin, size_t end)
+    {
+        offsets[chunk + 1] = RewriteChunk(source, begin, end, generation, nullptr);
+    });
+
+    for(size_t i = 1; i <= chunks; ++i)
+    {
+        offsets[i] += offsets[i - 1];
+    }
+
+    // Fill each chunk's output at its final offset
+    result.resize(offsets[chunks]);
+    pool.ParallelFor(source.size(), MIN_REWRITE_CHUNK,
+        [&](size_t chunk, size_t begin, size_t end)
+    {
+        RewriteChunk(source, begin, end, generation, &result[0] + offsets[chunk]);
+    });
+}
+
+void RuleSystem::Rewrite(const std::string& source,
+                         std::string& result,
+                         unsigned int generation) const
+{
+    result.resize(RewriteChunk(source, 0, source.size(), generation, nullptr));
+    RewriteChunk(source, 0, source.size(), generation, &result[0]);
+}
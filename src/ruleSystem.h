@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - ruleSystem.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+
+class ThreadPool;
+
+/**
+* Compiled L-system production table used to rewrite the tree rule string
+*/
+class RuleSystem
+{
+public:
+
+    static const size_t MIN_REWRITE_CHUNK = 1 << 16;  ///< Smallest amount of symbols given to a worker
+
+    /**
+    * The symbols that replace a single symbol during a rewrite
+    */
+    struct Replacement
+    {
+        const char* symbols;    ///< The replacement symbols or null if the symbol is removed
+        size_t length;          ///< The number of replacement symbols
+        const size_t* jumps;    ///< Position after each [ to its matching ] if branches can be pruned
+
+        /**
+        * Constructor
+        */
+        Replacement() :
+            symbols(nullptr),
+            length(0),
+            jumps(nullptr)
+        {
+        }
+    };
+
+    /**
+    * Constructor
+    */
+    RuleSystem();
+
+    /**
+    * Removes all productions
+    */
+    void Clear();
+
+    /**
+    * Adds a production for a symbol. If the symbol already
+    * has a production the first one added is kept
+    * @param symbol The rule character to replace
+    * @param production The symbols to replace the rule character with
+    * @param chance The probability from 0-100% of the production being used
+    */
+    void AddRule(char symbol, const std::string& production, unsigned int chance);
+
+    /**
+    * Sets the seed used to decide stochastic productions
+    * @param seed The seed to use
+    */
+    void SetSeed(unsigned int seed);
+
+    /**
+    * Sets whether branches die while they are derived rather than when the turtle reads them.
+    * Only branches opened and closed within a single production can be pruned
+    * @param probability The probability from 0-100% of a branch dying, 0 disables pruning
+    */
+    void SetBranchDeath(unsigned int probability);
+
+    /**
+    * Rewrites every symbol in the source string once
+    * @param source The string to rewrite
+    * @param result Filled with the rewritten string
+    * @param generation The current rewrite iteration
+    * @param pool The workers to split the rewrite across
+    */
+    void Rewrite(const std::string& source,
+                 std::string& result,
+                 unsigned int generation,
+                 ThreadPool& pool) const;
+
+    /**
+    * Rewrites every symbol in the source string once as a single chunk in order.
+    * Gives the same result as the split rewrite so can be used as its reference
+    * @param source The string to rewrite
+    * @param result Filled with the rewritten string
+    * @param generation The current rewrite iteration
+    */
+    void Rewrite(const std::string& source,
+                 std::string& result,
+                 unsigned int generation) const;
+
+    /**
+    * Finds the replacement for a single symbol. Non rule symbols are replaced by themselves
+    * @param generation The current rewrite iteration
+    * @param index The position of the symbol in the source string
+    * @param symbol The symbol being rewritten
+    * @return the replacement symbols
+    */
+    Replacement Replace(unsigned int generation,
+                        size_t index,
+                        const char& symbol) const;
+
+    /**
+    * Determines whether a branch within a replacement dies during derivation
+    * @param generation The current rewrite iteration
+    * @param index The position of the replaced symbol in the source string
+    * @param offset The position of the branch's [ within the replacement
+    * @return whether the branch should be removed
+    */
+    bool BranchDies(unsigned int generation, size_t index, size_t offset) const;
+
+    /**
+    * Generates a roll keyed on the symbol's position so any
+    * split or order of the derivation gives the same result
+    * @param generation The current rewrite iteration
+    * @param index The position of the symbol in the source string
+    * @param salt Distinguishes multiple rolls for the same symbol
+    * @return the roll from 0-100
+    */
+    int Roll(unsigned int generation, size_t index, size_t salt) const;
+
+    /**
+    * Determines the expected length of a derived string without deriving it
+    * @param axiom The string to start deriving from
+    * @param iterations The number of rewrite iterations
+    * @return the length, weighted by chance for any stochastic productions
+    */
+    double ExpectedLength(const std::string& axiom, unsigned int iterations) const;
+
+private:
+
+    /**
+    * Holds the replacement for a single symbol
+    */
+    struct Production
+    {
+        std::string symbols;        ///< The symbols to replace the rule character with
+        std::vector<size_t> jumps;  ///< Position after the matching ] for each [, 0 if unmatched
+        bool hasBranches;           ///< Whether the production opens and closes any branches
+        unsigned int chance;        ///< The probability from 0-100% of the production being used
+        bool isRule;                ///< Whether the symbol has a production
+
+        /**
+        * Constructor
+        */
+        Production() :
+            hasBranches(false),
+            chance(0),
+            isRule(false)
+        {
+        }
+    };
+
+    /**
+    * Counts or copies the symbols of a replacement
+    * @param generation The current rewrite iteration
+    * @param index The position of the replaced symbol in the source string
+    * @param replacement The symbols replacing the symbol
+    * @param output The buffer to copy into or null to only count
+    * @return the number of symbols
+    */
+    size_t Emit(unsigned int generation,
+                size_t index,
+                const Replacement& replacement,
+                char* output) const;
+
+    /**
+    * Counts or copies the rewritten symbols of a range of the source string
+    * @param source The string being rewritten
+    * @param begin The position of the first symbol of the range
+    * @param end The position after the last symbol of the range
+    * @param generation The current rewrite iteration
+    * @param output The buffer to copy into or null to only count
+    * @return the number of symbols
+    */
+    size_t RewriteChunk(const std::string& source,
+                        size_t begin,
+                        size_t end,
+                        unsigned int generation,
+                        char* output) const;
+
+    std::array<Production, 256> m_table;    ///< Direct lookup from symbol to production
+    unsigned int m_seed = 0;                ///< Seed for stochastic productions
+    unsigned int m_branchDeath = 0;         ///< Probability from 0-100% of a derived branch dying
+};
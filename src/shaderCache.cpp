@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - shaderCache.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "shaderCache.h"
+
+#include <algorithm>
+
+MString ShaderCache::AcquireBranchShader(const ShadingData& shading, const MString& name)
+{
+    // Bump depth only changes the network when a bump is used
+    const BranchKey key(shading.lightcolorR, shading.lightcolorG, shading.lightcolorB,
+        shading.darkcolorR, shading.darkcolorG, shading.darkcolorB, shading.createBump,
+        shading.createBump ? shading.bumpAmount : 0.0);
+
+    if(Network* network = Find(m_branchShaders, key))
+    {
+        ++network->users;
+        return ShadingGroupName(*network);
+    }
+
+    MDGModifier dgMod;
+    Network& network = m_branchShaders[key];
+    MObject shader = CreateSurfaceShader(dgMod, network, name);
+
+    MObject noise = CreateNode(dgMod, network, "volumeNoise",
+        name + "_noise", "defaultTextureList1", "textures");
+
+    MFnDependencyNode shaderFn(shader);
+    MFnDependencyNode noiseFn(noise);
+    dgMod.connect(noiseFn.findPlug("outColor", true), shaderFn.findPlug("color", true));
+
+    SetColor(dgMod, noise, "colorGain", shading.lightcolorR,
+        shading.lightcolorG, shading.lightcolorB);
+
+    SetColor(dgMod, noise, "colorOffset", shading.darkcolorR,
+        shading.darkcolorG, shading.darkcolorB);
+
+    dgMod.newPlugValueInt(noiseFn.findPlug("noiseType", true), 3);
+    dgMod.newPlugValueBool(noiseFn.findPlug("alphaIsLuminance", true), true);
+    dgMod.newPlugValueDouble(noiseFn.findPlug("frequencyRatio", true), 0.5);
+
+    if(shading.createBump)
+    {
+        MObject bump = CreateNode(dgMod, network, "bump3d",
+            name + "_bump", "defaultRenderUtilityList1", "utilities");
+
+        MFnDependencyNode bumpFn(bump);
+        dgMod.connect(noiseFn.findPlug("outAlpha", true), bumpFn.findPlug("bumpValue", true));
+        dgMod.connect(bumpFn.findPlug("outNormal", true), shaderFn.findPlug("normalCamera", true));
+        dgMod.newPlugValueDouble(bumpFn.findPlug("bumpDepth", true), shading.bumpAmount);
+    }
+
+    dgMod.doIt();
+    network.users = 1;
+    return ShadingGroupName(network);
+}
+
+MString ShaderCache::AcquireLeafShader(const LeafData& leaf, const MString& name)
+{
+    const std::string& key = leaf.file;
+    if(Network* network = Find(m_leafShaders, key))
+    {
+        ++network->users;
+        return ShadingGroupName(*network);
+    }
+
+    MDGModifier dgMod;
+    Network& network = m_leafShaders[key];
+    MObject shader = CreateSurfaceShader(dgMod, network, name);
+
+    MObject texture = CreateNode(dgMod, network, "file",
+        name + "_file", "defaultTextureList1", "textures");
+
+    MFnDependencyNode shaderFn(shader);
+    MFnDependencyNode textureFn(texture);
+    dgMod.connect(textureFn.findPlug("outColor", true), shaderFn.findPlug("color", true));
+    dgMod.connect(textureFn.findPlug("outTransparency", true), shaderFn.findPlug("transparency", true));
+    dgMod.newPlugValueString(textureFn.findPlug("fileTextureName", true), MString(leaf.file.c_str()));
+    dgMod.newPlugValueDouble(shaderFn.findPlug("shadowAttenuation", true), 0.0);
+
+    dgMod.doIt();
+    network.users = 1;
+    return ShadingGroupName(network);
+}
+
+void ShaderCache::Release(const MString& shadingGroup)
+{
+    auto release = [this, &shadingGroup](auto& networks)
+    {
+        for(auto itr = networks.begin(); itr != networks.end(); ++itr)
+        {
+            Network& network = itr->second;
+            if(network.shadingGroup.isValid() && ShadingGroupName(network) == shadingGroup)
+            {
+                if(--network.users <= 0)
+                {
+                    MDGModifier dgMod;
+                    for(const MObject& node : network.nodes)
+                    {
+                        dgMod.deleteNode(node);
+                    }
+                    dgMod.doIt();
+                    networks.erase(itr);
+                }
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if(!release(m_branchShaders))
+    {
+        release(m_leafShaders);
+    }
+}
+
+template<typename Key>
+ShaderCache::Network* ShaderCache::Find(std::map<Key, Network>& networks, const Key& key)
+{
+    auto itr = networks.find(key);
+    if(itr == networks.end())
+    {
+        return nullptr;
+    }
+
+    // The user may have deleted the network or opened a new scene
+    if(!itr->second.shadingGroup.isValid())
+    {
+        networks.erase(itr);
+        return nullptr;
+    }
+    return &itr->second;
+}
+
+MObject ShaderCache::CreateSurfaceShader(MDGModifier& dgMod, Network& network, const MString& name)
+{
+    MObject shader = CreateNode(dgMod, network, "lambert",
+        name, "defaultShaderList1", "shaders");
+
+    MObject shadingGroup = dgMod.createNode("shadingEngine");
+    dgMod.renameNode(shadingGroup, name + "SG");
+    network.nodes.push_back(shadingGroup);
+    network.shadingGroup = MObjectHandle(shadingGroup);
+
+    MFnDependencyNode shaderFn(shader);
+    MFnDependencyNode shadingGroupFn(shadingGroup);
+    dgMod.connect(shaderFn.findPlug("outColor", true),
+        shadingGroupFn.findPlug("surfaceShader", true));
+
+    // Shading groups only render as part of the render partition
+    ConnectToNext(dgMod, shadingGroupFn.findPlug("partition", true), "renderPartition", "sets");
+    return shader;
+}
+
+MObject ShaderCache::CreateNode(MDGModifier& dgMod,
+                                Network& network,
+                                const MString& type,
+                                const MString& name,
+                                const MString& list,
+                                const MString& attribute)
+{
+    MObject node = dgMod.createNode(type);
+    dgMod.renameNode(node, name);
+    network.nodes.push_back(node);
+
+    MFnDependencyNode nodeFn(node);
+    ConnectToNext(dgMod, nodeFn.findPlug("message", true), list, attribute);
+    return node;
+}
+
+void ShaderCache::ConnectToNext(MDGModifier& dgMod,
+                                const MPlug& source,
+                                const MString& node,
+                                const MString& attribute)
+{
+    MSelectionList list;
+    MObject object;
+    if(!list.add(node) || !list.getDependNode(0, object))
+    {
+        return;
+    }
+
+    MPlug array = MFnDependencyNode(object).findPlug(attribute, true);
+    MIntArray indices;
+    array.getExistingArrayAttributeIndices(indices);
+
+    int next = 0;
+    for(unsigned int i = 0; i < indices.length(); ++i)
+    {
+        next = std::max(next, indices[i] + 1);
+    }
+    dgMod.connect(source, array.elementByLogicalIndex(next));
+}
+
+void ShaderCache::SetColor(MDGModifier& dgMod,
+                           const MObject& node,
+                           const MString& attribute,
+                           double r, double g, double b)
+{
+    MFnDependencyNode nodeFn(node);
+    dgMod.newPlugValueDouble(nodeFn.findPlug(attribute + "R", true), r);
+    dgMod.newPlugValueDouble(nodeFn.findPlug(attribute + "G", true), g);
+    dgMod.newPlugValueDouble(nodeFn.findPlug(attribute + "B", true), b);
+}
+
+MString ShaderCache::ShadingGroupName(const Network& network) const
+{
+    return MFnDependencyNode(network.shadingGroup.object()).name();
+}
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - shaderCache.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "common.h"
+#include "treeComponents.h"
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/**
+* Builds shader networks through a DG modifier and shares them between all
+* trees of the Maya session that are created with the same shading settings
+*/
+class ShaderCache
+{
+public:
+
+    /**
+    * Gets a shading group for the branches, creating the network if no tree uses it yet
+    * @param shading The colors and bump for the shader
+    * @param name The name to give the network if it is created
+    * @return the name of the shading group
+    */
+    MString AcquireBranchShader(const ShadingData& shading, const MString& name);
+
+    /**
+    * Gets a shading group for the leaves, creating the network if no tree uses it yet
+    * @param leaf The texture for the shader
+    * @param name The name to give the network if it is created
+    * @return the name of the shading group
+    */
+    MString AcquireLeafShader(const LeafData& leaf, const MString& name);
+
+    /**
+    * Stops a tree using a shading group, deleting its network once no trees use it
+    * @param shadingGroup The name of the shading group given when acquired
+    */
+    void Release(const MString& shadingGroup);
+
+private:
+
+    /**
+    * The settings that decide what a branch shader looks like
+    */
+    typedef std::tuple<double, double, double, double, double, double, bool, double> BranchKey;
+
+    /**
+    * Nodes of a single shader network
+    */
+    struct Network
+    {
+        MObjectHandle shadingGroup;     ///< The shading group meshes are added to
+        std::vector<MObject> nodes;     ///< All nodes of the network
+        int users = 0;                  ///< Number of trees using the network
+    };
+
+    /**
+    * Finds a network in the cache which still exists in the scene
+    * @param networks The networks to search
+    * @param key The settings of the network
+    * @return the network or null if it needs to be created
+    */
+    template<typename Key>
+    Network* Find(std::map<Key, Network>& networks, const Key& key);
+
+    /**
+    * Creates a lambert shader and the shading group that renders it
+    * @param dgMod The modifier to create the nodes with
+    * @param network Filled with the shader and shading group
+    * @param name The name of the shader
+    * @return the shader node
+    */
+    MObject CreateSurfaceShader(MDGModifier& dgMod, Network& network, const MString& name);
+
+    /**
+    * Creates a node and lists it so it shows in the hypershade
+    * @param dgMod The modifier to create the node with
+    * @param network Filled with the node
+    * @param type The type of node to create
+    * @param name The name of the node
+    * @param list The name of the default list to add the node to
+    * @param attribute The array attribute of the list
+    * @return the created node
+    */
+    MObject CreateNode(MDGModifier& dgMod,
+                       Network& network,
+                       const MString& type,
+                       const MString& name,
+                       const MString& list,
+                       const MString& attribute);
+
+    /**
+    * Connects a node to the next free element of an array attribute on a named node
+    * @param dgMod The modifier to connect with
+    * @param source The plug to connect from
+    * @param node The name of the node holding the array
+    * @param attribute The array attribute to connect to
+    */
+    void ConnectToNext(MDGModifier& dgMod,
+                       const MPlug& source,
+                       const MString& node,
+                       const MString& attribute);
+
+    /**
+    * Sets a color attribute
+    * @param dgMod The modifier to set the value with
+    * @param node The node holding the attribute
+    * @param attribute The name of the color attribute
+    * @param r/g/b The components of the color
+    */
+    void SetColor(MDGModifier& dgMod,
+                  const MObject& node,
+                  const MString& attribute,
+                  double r, double g, double b);
+
+    /**
+    * @param network The network to get the shading group of
+    * @return the current name of the shading group
+    */
+    MString ShadingGroupName(const Network& network) const;
+
+    std::map<BranchKey, Network> m_branchShaders;   ///< Branch networks by shading settings
+    std::map<std::string, Network> m_leafShaders;   ///< Leaf networks by texture file
+};
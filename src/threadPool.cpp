@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - threadPool.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "threadPool.h"
+
+#include <cassert>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    if(threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for(unsigned int i = 0; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_taskAdded.notify_all();
+    for(std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+unsigned int ThreadPool::Size() const
+{
+    return static_cast<unsigned int>(m_workers.size());
+}
+
+size_t ThreadPool::ChunkCount(size_t count, size_t minChunk) const
+{
+    // Over-split slightly so uneven chunks balance out across workers
+    const size_t maxChunks = m_workers.size() * 4;
+    const size_t chunks = count / std::max(minChunk, size_t(1));
+    return std::max(size_t(1), std::min(chunks, maxChunks));
+}
+
+void ThreadPool::Push(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+        ++m_outstanding;
+    }
+    m_taskAdded.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    assert(!IsWorker() && "A task waiting on its own pool never finishes");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasksDone.wait(lock, [this]() { return m_outstanding == 0; });
+}
+
+bool ThreadPool::WaitFor(unsigned int milliseconds)
+{
+    assert(!IsWorker() && "A task waiting on its own pool never finishes");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_tasksDone.wait_for(lock, std::chrono::milliseconds(milliseconds),
+        [this]() { return m_outstanding == 0; });
+}
+
+bool ThreadPool::IsWorker() const
+{
+    const std::thread::id id = std::this_thread::get_id();
+    for(const std::thread& worker : m_workers)
+    {
+        if(worker.get_id() == id)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for(;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskAdded.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            if(m_stopping && m_tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(--m_outstanding == 0)
+        {
+            m_tasksDone.notify_all();
+        }
+    }
+}
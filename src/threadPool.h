@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - threadPool.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+
+/**
+* Fixed size pool of worker threads that process queued tasks
+*/
+class ThreadPool
+{
+public:
+
+    /**
+    * Constructor
+    * @param threadCount The number of workers, 0 will use all available cores
+    */
+    explicit ThreadPool(unsigned int threadCount = 0);
+
+    /**
+    * Destructor
+    */
+    ~ThreadPool();
+
+    /**
+    * @return the number of worker threads
+    */
+    unsigned int Size() const;
+
+    /**
+    * Queues a task to be run by a worker. Tasks may queue further tasks
+    * but must never wait on the pool as they would wait on themselves
+    * @param task The task to run
+    */
+    void Push(std::function<void()> task);
+
+    /**
+    * Blocks until all queued tasks have finished
+    * @note only call from outside the pool, never from a task
+    */
+    void Wait();
+
+    /**
+    * Blocks until all queued tasks have finished or the time has passed
+    * @param milliseconds The longest time to wait for
+    * @return whether all tasks have finished
+    * @note only call from outside the pool, never from a task
+    */
+    bool WaitFor(unsigned int milliseconds);
+
+    /**
+    * Splits a range into contiguous chunks and runs them across the workers
+    * @param count The number of elements in the range
+    * @param minChunk The smallest amount of elements to give to a single chunk
+    * @param fn Called as fn(chunk, begin, end) for each chunk
+    * @return the number of chunks the range was split into
+    * @note only call from outside the pool, never from a task, as it waits for all tasks
+    */
+    template<typename Fn> size_t ParallelFor(size_t count, size_t minChunk, Fn fn)
+    {
+        const size_t chunks = ChunkCount(count, minChunk);
+        if(chunks <= 1)
+        {
+            fn(size_t(0), size_t(0), count);
+            return 1;
+        }
+
+        const size_t size = (count + chunks - 1) / chunks;
+        for(size_t i = 0; i < chunks; ++i)
+        {
+            const size_t begin = i * size;
+            const size_t end = std::min(count, begin + size);
+            Push([=]() { fn(i, begin, end); });
+        }
+        Wait();
+        return chunks;
+    }
+
+    /**
+    * @param count The number of elements in the range
+    * @param minChunk The smallest amount of elements to give to a single chunk
+    * @return the number of chunks ParallelFor will use for the range
+    */
+    size_t ChunkCount(size_t count, size_t minChunk) const;
+
+private:
+
+    /**
+    * Prevent copying
+    */
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+    * @return whether the calling thread is one of the workers
+    */
+    bool IsWorker() const;
+
+    /**
+    * Main loop for each worker thread
+    */
+    void WorkerLoop();
+
+    std::vector<std::thread> m_workers;             ///< All worker threads
+    std::deque<std::function<void()>> m_tasks;      ///< Tasks waiting to be run
+    std::mutex m_mutex;                             ///< Guards the task queue
+    std::condition_variable m_taskAdded;            ///< Signals a task has been queued
+    std::condition_variable m_tasksDone;            ///< Signals all tasks have finished
+    unsigned int m_outstanding = 0;                 ///< Number of queued or running tasks
+    bool m_stopping = false;                        ///< Whether the workers should exit
+};
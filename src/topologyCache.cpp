@@ -0,0 +1,27 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - topologyCache.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "topologyCache.h"
+
+const MeshBuffer& TopologyCache::Get(int index) const
+{
+    return m_topologies[index];
+}
+
+size_t TopologyCache::Size() const
+{
+    return m_used;
+}
+
+void TopologyCache::Reset()
+{
+    m_indices.clear();
+    m_used = 0;
+}
+
+void TopologyCache::Release()
+{
+    Reset();
+    std::vector<MeshBuffer>().swap(m_topologies);
+}
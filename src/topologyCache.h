@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - topologyCache.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeComponents.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+/**
+* Faces and uvs of branch meshes shared between all branches of a tree with the
+* same shape. Only vertex positions then differ between these branches
+*/
+class TopologyCache
+{
+public:
+
+    /**
+    * Gets the topology for a branch shape, creating it if no branch uses it yet.
+    * Not safe to call from the workers
+    * @param sections The number of rings of the branch
+    * @param faces The number of faces around the branch
+    * @param capped Whether the end of the branch is capped
+    * @param create Called as create(topology) to fill an empty topology for the shape
+    * @return the index of the topology
+    */
+    template<typename Create> 
+    int Acquire(int sections, int faces, bool capped, Create create)
+    {
+        const Shape shape(sections, faces, capped);
+        auto found = m_indices.find(shape);
+        if(found != m_indices.end())
+        {
+            return found->second;
+        }
+
+        if(m_used == m_topologies.size())
+        {
+            m_topologies.emplace_back();
+        }
+
+        MeshBuffer& topology = m_topologies[m_used];
+        topology.Clear();
+        create(topology);
+
+        const int index = static_cast<int>(m_used++);
+        m_indices.emplace(shape, index);
+        return index;
+    }
+
+    /**
+    * @param index The index given when the topology was acquired
+    * @return the topology with vertex and uv indices starting from zero
+    */
+    const MeshBuffer& Get(int index) const;
+
+    /**
+    * @return the number of topologies acquired since the reset
+    */
+    size_t Size() const;
+
+    /**
+    * Removes all topologies, keeping their memory for the next tree
+    */
+    void Reset();
+
+    /**
+    * Frees the memory of all topologies
+    */
+    void Release();
+
+private:
+
+    /**
+    * The sections, faces and capping that decide the topology of a branch
+    */
+    typedef std::tuple<int, int, bool> Shape;
+
+    std::map<Shape, int> m_indices;         ///< Index of the topology for each shape
+    std::vector<MeshBuffer> m_topologies;   ///< Topologies in the order they were acquired
+    size_t m_used = 0;                      ///< Number of topologies acquired since the reset
+};
@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeArguments.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "treeArguments.h"
+#include "randomGenerator.h"
+
+#include <climits>
+
+const std::vector<TreeArguments::Flag>& TreeArguments::Flags()
+{
+    const ArgumentType B = ARGUMENT_BOOLEAN;
+    const ArgumentType U = ARGUMENT_UNSIGNED;
+    const ArgumentType D = ARGUMENT_DOUBLE;
+    const ArgumentType S = ARGUMENT_STRING;
+
+    static const std::vector<Flag> flags =
+    {
+        { "-i", "-iterations", { U } },
+        { "-bd", "-branchdeath", { U } },
+        { "-sr", "-streamrule", { B } },
+        { "-pb", "-prunebranches", { B } },
+        { "-sd", "-seed", { U } },
+        { "-mm", "-meshmode", { U } },
+        { "-lm", "-leafmode", { U } },
+        { "-v", "-preview", { B } },
+        { "-fi", "-file", { S } },
+        { "-l", "-leaf", { B, U } },
+        { "-a", "-angle", { D, D } },
+        { "-ta", "-tangle", { D, D } },
+        { "-m", "-meshdata", { B, B, B } },
+        { "-tf", "-tforward", { D, D, D } },
+        { "-f", "-forward", { D, D, D } },
+        { "-fa", "-faces", { U, U, U } },
+        { "-lo", "-lods", { U } },
+        { "-rp", "-prerule", { S, S, S } },
+        { "-r", "-radius", { D, D, D, D, D } },
+        { "-ld", "-leafdata", { D, D, D, D, D } },
+        { "-c", "-color", { D, D, D, D, D, D } },
+        { "-cd", "-colordata", { B, B, B, D, D } },
+        { "-r1", "-rule1", { S, S, S, S, S } },
+        { "-r2", "-rule2", { S, S, S, S, S } },
+        { "-rc1", "-rulec1", { S, S, S, S, S } },
+        { "-rc2", "-rulec2", { S, S, S, S, S } },
+        { "-rp1", "-rulep1", { U, U, U, U, U } },
+        { "-rp2", "-rulep2", { U, U, U, U, U } },
+        { "-pf", "-profile", { B } },
+        { "-trf", "-tracefile", { S } },
+        { "-es", "-estimate", { B } }
+    };
+    return flags;
+}
+
+void TreeArguments::Read(TreeParameters& parameters) const
+{
+    MeshData& meshdata = parameters.mesh;
+    LeafData& leafdata = parameters.leaf;
+    TreeData& treedata = parameters.tree;
+    ShadingData& fxdata = parameters.shading;
+    BranchData& branch = parameters.branch;
+    BranchData& trunk = parameters.trunk;
+
+    Get("-fi", 0, leafdata.file);
+    Get("-l", 0, leafdata.treeHasLeaves);
+    Get("-l", 1, leafdata.leafLayer);
+    Get("-ld", 0, leafdata.bendAmount);
+    Get("-ld", 1, leafdata.height);
+    Get("-ld", 2, leafdata.width);
+    Get("-ld", 3, leafdata.heightVariance);
+    Get("-ld", 4, leafdata.widthVariance);
+    Get("-m", 0, meshdata.createAsCurves);
+    Get("-m", 1, meshdata.capEnds);
+    Get("-m", 2, meshdata.randomize);
+    Get("-v", 0, meshdata.preview);
+    Get("-mm", 0, meshdata.meshMode);
+    Get("-lm", 0, leafdata.leafMode);
+    Get("-fa", 0, meshdata.trunkfaces);
+    Get("-fa", 1, meshdata.branchfaces);
+    Get("-fa", 2, meshdata.faceDecrease);
+    Get("-lo", 0, meshdata.lods);
+    Get("-i", 0, parameters.iterations);
+    Get("-a", 0, branch.angle);
+    Get("-a", 1, branch.angleVariance);
+    Get("-f", 0, branch.forward);
+    Get("-f", 1, branch.forwardVariance);
+    Get("-f", 2, branch.forwardAngle);
+    Get("-r", 2, branch.radiusDecrease);
+    Get("-ta", 0, trunk.angle);
+    Get("-ta", 1, trunk.angleVariance);
+    Get("-tf", 0, trunk.forward);
+    Get("-tf", 1, trunk.forwardVariance);
+    Get("-tf", 2, trunk.forwardAngle);
+    Get("-r", 3, trunk.radiusDecrease);
+    Get("-r", 0, treedata.initialRadius);
+    Get("-r", 1, treedata.branchRadiusDecrease);
+    Get("-r", 4, treedata.minimumRadius);
+    Get("-bd", 0, treedata.branchDeathProbability);
+    Get("-sr", 0, treedata.streamRule);
+    Get("-pb", 0, treedata.pruneBranches);
+    Get("-c", 0, fxdata.lightcolorR);
+    Get("-c", 1, fxdata.lightcolorG);
+    Get("-c", 2, fxdata.lightcolorB);
+    Get("-c", 3, fxdata.darkcolorR);
+    Get("-c", 4, fxdata.darkcolorG);
+    Get("-c", 5, fxdata.darkcolorB);
+    Get("-cd", 0, fxdata.createTreeShader);
+    Get("-cd", 1, fxdata.createLeafShader);
+    Get("-cd", 2, fxdata.createBump);
+    Get("-cd", 3, fxdata.bumpAmount);
+    Get("-cd", 4, fxdata.uvBleedSpace);
+    Get("-rp", 0, treedata.prerule);
+    Get("-rp", 1, treedata.axiom);
+    Get("-rp", 2, treedata.postrule);
+
+    const int HALF_MAX_RULES = TreeParameters::RULE_NUMBER/2;
+    for(int i = 0; i < HALF_MAX_RULES; ++i)
+    {
+        Get("-r1", i, parameters.ruleStrings[i]);
+        Get("-rc1", i, parameters.ruleIDs[i]);
+        Get("-rp1", i, parameters.ruleChances[i]);
+        Get("-r2", i, parameters.ruleStrings[HALF_MAX_RULES + i]);
+        Get("-rc2", i, parameters.ruleIDs[HALF_MAX_RULES + i]);
+        Get("-rp2", i, parameters.ruleChances[HALF_MAX_RULES + i]);
+    }
+
+    // Set preview variables
+    if(meshdata.preview)
+    {
+        meshdata.createAsCurves = true;
+        leafdata.treeHasLeaves = false;
+        fxdata.createTreeShader = false;
+        fxdata.createLeafShader = false;
+    }
+
+    // Generate a new seed if randomize chosen
+    if(meshdata.randomize)
+    {
+        Random::RandomizeSeed();
+    }
+
+    // Use the given seed so the tree can be regenerated exactly
+    if(IsFlagSet("-sd"))
+    {
+        Get("-sd", 0, treedata.seed);
+    }
+    else
+    {
+        treedata.seed = static_cast<unsigned int>(Random::Generate(0, INT_MAX));
+    }
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeArguments.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeComponents.h"
+
+#include <string>
+#include <vector>
+
+/**
+* Reads the flags that customise a tree. Every front end
+* shares the same flags and how they map to the parameters
+*/
+class TreeArguments
+{
+public:
+
+    /**
+    * The type of value given to a flag
+    */
+    enum ArgumentType
+    {
+        ARGUMENT_BOOLEAN,
+        ARGUMENT_UNSIGNED,
+        ARGUMENT_DOUBLE,
+        ARGUMENT_STRING
+    };
+
+    /**
+    * A flag and the values it takes
+    */
+    struct Flag
+    {
+        const char* shortName;                  ///< Name of the flag, eg. -i
+        const char* longName;                   ///< Descriptive name of the flag, eg. -iterations
+        std::vector<ArgumentType> arguments;    ///< Type of each value of the flag
+    };
+
+    /**
+    * Destructor
+    */
+    virtual ~TreeArguments() = default;
+
+    /**
+    * @return all flags that can be given
+    */
+    static const std::vector<Flag>& Flags();
+
+    /**
+    * Fills the parameters from the flags given. Flags not given keep their current value
+    * @param parameters The parameters to fill
+    */
+    void Read(TreeParameters& parameters) const;
+
+    /**
+    * @param flag The short name of the flag
+    * @return whether the flag was given
+    */
+    virtual bool IsFlagSet(const char* flag) const = 0;
+
+    /**
+    * Gets a value of a flag, leaving it unchanged if the flag was not given
+    * @param flag The short name of the flag
+    * @param index The index of the value for the flag
+    * @param value Filled with the value
+    */
+    virtual void Get(const char* flag, unsigned int index, bool& value) const = 0;
+    virtual void Get(const char* flag, unsigned int index, unsigned int& value) const = 0;
+    virtual void Get(const char* flag, unsigned int index, double& value) const = 0;
+    virtual void Get(const char* flag, unsigned int index, std::string& value) const = 0;
+};
@@ -0,0 +1,1715 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeBuilder.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "treeBuilder.h"
+#include "treeHelpers.h"
+#include "randomGenerator.h"
+#include "threadPool.h"
+#include "ruleStream.h"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+namespace
+{
+    const size_t MIN_SPLIT_SYMBOLS = 1 << 14;   ///< Default smallest branch given to another worker
+    const unsigned int PROGRESS_SYMBOLS = 1024; ///< Symbols read between progress reports
+    const unsigned int PROGRESS_INTERVAL_MS = 50; ///< Time between checking on the workers
+    const unsigned int TURTLE_STREAM = 1;         ///< Random stream id for the trunk's turtle
+    const unsigned int LEAF_STREAM = 2;           ///< Random stream id for the leaves
+    const unsigned int LEAF_RANDOMS = 5;          ///< Random values used to create a leaf
+    const size_t MESH_BATCH = 8192;               ///< Branches or leaves computed before committing them
+    const size_t MIN_MESH_CHUNK = 64;             ///< Smallest amount of branches given to a worker
+    const size_t MIN_LEAF_CHUNK = 1024;           ///< Smallest amount of leaves given to a worker
+    const float LOD_RADIUS_STEP = 1.5f;           ///< Growth per level of detail of the thinnest branch kept
+    const float LOD_STRAIGHT_ANGLE = 20.0f;       ///< Bend in degrees per level of detail below which sections are removed
+
+    /**
+    * Carries a ring frame to the next ring with the least rotation by reflecting it
+    * across the plane between the rings and then onto the next tangent
+    * @param frame The frame of the previous ring
+    * @param from The position of the previous ring
+    * @param to The position of the next ring
+    * @param tangent The direction the next ring faces
+    * @return the frame of the next ring
+    */
+    RingFrame TransportFrame(const RingFrame& frame, 
+                             const Float3& from, 
+                             const Float3& to, 
+                             const Float3& tangent)
+    {
+        const float tangentLength = tangent.SquaredLength();
+        if(tangentLength <= 0.0f)
+        {
+            return frame;
+        }
+
+        RingFrame next;
+        next.tangent = tangent * (1.0f / std::sqrt(tangentLength));
+
+        // Rings at the same position reflect across the previous ring instead
+        Float3 step = to - from;
+        float stepLength = step.SquaredLength();
+        if(stepLength <= 0.0f)
+        {
+            step = frame.tangent;
+            stepLength = 1.0f;
+        }
+
+        Float3 normal = frame.normal - step * (2.0f * step.Dot(frame.normal) / stepLength);
+        const Float3 reflected = frame.tangent - step * (2.0f * step.Dot(frame.tangent) / stepLength);
+
+        const Float3 align = next.tangent - reflected;
+        const float alignLength = align.SquaredLength();
+        if(alignLength > 0.0f)
+        {
+            normal -= align * (2.0f * align.Dot(normal) / alignLength);
+        }
+
+        // Remove any drift from the tangent
+        normal -= next.tangent * next.tangent.Dot(normal);
+        normal.Normalize();
+        next.normal = normal;
+        return next;
+    }
+
+    /**
+    * Copies the uvs of a shared topology into a mesh
+    * @param topology The topology to copy from
+    * @param mesh The mesh to copy to
+    * @param start The first uv of the mesh to copy to
+    */
+    void CopyUVs(const MeshBuffer& topology, MeshBuffer& mesh, size_t start)
+    {
+        std::copy(topology.uCoord.begin(), topology.uCoord.end(), &mesh.uCoord[start]);
+        std::copy(topology.vCoord.begin(), topology.vCoord.end(), &mesh.vCoord[start]);
+    }
+
+    /**
+    * Creates the transform of a ring around a section
+    * @param frame The orientation of the ring
+    * @param position The center of the ring
+    * @param radius The radius of the ring
+    * @return the transform from the disk to the ring
+    */
+    Matrix RingTransform(const RingFrame& frame, const Float3& position, float radius)
+    {
+        Matrix transform;
+        transform.SetRight(frame.normal * radius);
+        transform.SetUp(frame.tangent * radius);
+        transform.SetForward(frame.normal.Cross(frame.tangent) * radius);
+        transform.SetPosition(position);
+        return transform;
+    }
+}
+
+TreeBuilder::TreeBuilder(const TreeParameters& parameters, 
+                         TreeProgress& progress, 
+                         TreeWorkspace* workspace)
+    : m_progress(progress)
+    , m_ownWorkspace(workspace ? nullptr : std::make_unique<TreeWorkspace>())
+    , m_workspace(workspace ? *workspace : *m_ownWorkspace)
+    , m_threads(m_workspace.Threads())
+    , m_parameters(parameters)
+    , m_meshdata(m_parameters.mesh)
+    , m_leafdata(m_parameters.leaf)
+    , m_treedata(m_parameters.tree)
+    , m_fxdata(m_parameters.shading)
+    , m_skeleton(m_workspace.skeleton)
+    , m_leaves(m_workspace.leaves)
+    , m_leafTopology(m_workspace.leafTopology)
+    , m_rule(m_workspace.rule)
+{
+    m_workspace.Reset();
+    m_splitSymbols = MIN_SPLIT_SYMBOLS;
+
+    // Progress is split between building, meshing and leafing
+    const unsigned int steps = m_leafdata.treeHasLeaves ? 3 : 2;
+    m_progressIncrease = 100 / steps;
+    m_progressStep = 2;
+}
+
+TreeBuilder::~TreeBuilder() = default;
+
+void TreeBuilder::SetProfiler(Profiler* profiler)
+{
+    m_profiler = profiler;
+}
+
+void TreeBuilder::SetSplitSymbols(size_t symbols)
+{
+    m_splitSymbols = symbols;
+}
+
+bool TreeBuilder::BuildSkeleton()
+{
+    // Create the rule string
+    CompileRules();
+
+    if(!m_treedata.streamRule)
+    {
+        Profiler::Scope scope(m_profiler, "CreateRuleString");
+        m_rule = m_treedata.axiom;
+        if(!CreateRuleString()) 
+        { 
+            return false;
+        }
+
+        // Add prerule/postrule
+        std::string& scratch = m_workspace.scratchRule;
+        scratch = m_treedata.prerule;
+        scratch += m_rule;
+        scratch += m_treedata.postrule;
+        m_rule.swap(scratch);
+
+        if(m_profiler)
+        {
+            m_profiler->Count("symbols", m_rule.size());
+        }
+    }
+
+    // Navigate the turtle
+    return BuildTheTree();
+}
+
+bool TreeBuilder::CreateGeometry(TreeOutput& output, const std::string& treename)
+{
+    m_treedata.treename = treename;
+
+    if(m_meshdata.createAsCurves)
+    {
+        // Create curve tree
+        Profiler::Scope scope(m_profiler, "CreateCurves");
+        if(!CreateCurves(output))
+        { 
+            return false;
+        }
+    } 
+    else
+    {
+        // Create mesh tree
+        Profiler::Scope scope(m_profiler, "CreateMeshes");
+        if(!CreateMeshes(output))
+        { 
+            return false;
+        }
+    }
+
+    // Leaf the tree
+    if(m_leafdata.treeHasLeaves)
+    {
+        Profiler::Scope scope(m_profiler, "CreateLeaves");
+        if(m_profiler)
+        {
+            m_profiler->Count("leaves", m_leaves.size());
+        }
+        return CreateLeaves(output);
+    }
+    return true;
+}
+
+int TreeBuilder::LayerCount() const
+{
+    return m_meshdata.maxLayers + 1;
+}
+
+const TreeParameters& TreeBuilder::Parameters() const
+{
+    return m_parameters;
+}
+
+bool TreeBuilder::BuildTheTree()
+{
+    Profiler::Scope scope(m_profiler, "BuildTheTree");
+
+    // Set up progress
+    m_progress.Describe("Building:");
+
+    // Create the turtle
+    Turtle turtle;
+    turtle.orientation.RotateXLocal(static_cast<float>(DegToRad(90.0f)));
+    turtle.radius = m_treedata.initialRadius;
+    turtle.branchIndex = 0;
+    turtle.sectionIndex = 0;
+    turtle.layerIndex = 0;
+    turtle.branchParent = -1;
+    turtle.branchEnded = false;
+    turtle.sectionPosition = turtle.position;
+
+    // Set up tree
+    SkeletonPart& tree = m_workspace.AcquirePart();
+    tree.parents.push_back(-1);
+    tree.layers.push_back(0);
+    tree.sectionCounts.push_back(1);
+    tree.positions.push_back(turtle.position);
+    tree.radii.push_back(static_cast<float>(m_treedata.initialRadius));
+    tree.sectionBranches.push_back(0);
+    tree.randoms.push_back(RandomStream(m_treedata.seed, TURTLE_STREAM));
+    tree.childCounts.push_back(0);
+
+    // Navigate the turtle across the workers
+    m_symbolsRead = 0;
+    m_turtlesCancelled = false;
+    std::unique_ptr<RuleStream> stream;
+    std::unique_ptr<RuleReader> reader;
+    size_t symbolCount = 0;
+
+    if(m_treedata.streamRule)
+    {
+        stream = std::make_unique<RuleStream>(m_rules, m_treedata.prerule, 
+            m_treedata.axiom, m_treedata.postrule, m_parameters.iterations);
+
+        symbolCount = stream->Size();
+        m_threads.Push([&]() { NavigateTurtle(*stream, tree, turtle); });
+    }
+    else
+    {
+        reader = std::make_unique<RuleReader>(m_rule, true);
+        symbolCount = reader->Size();
+        m_threads.Push([&]() { NavigateTurtle(*reader, tree, turtle); });
+    }
+
+    m_symbolCount = symbolCount;
+    if(!WaitForTurtles(symbolCount))
+    {
+        return false;
+    }
+
+    MergeSkeleton(tree, nullptr);
+    BuildHierarchy(m_skeleton);
+
+    if(m_profiler)
+    {
+        m_profiler->Count("symbols", symbolCount);
+        m_profiler->Count("branches", m_skeleton.BranchCount());
+        m_profiler->Count("sections", m_skeleton.SectionCount());
+        m_profiler->Count("leaves", m_leaves.size());
+        m_profiler->Count("splits", m_workspace.PartCount() - 1);
+    }
+    return true;
+}
+
+bool TreeBuilder::WaitForTurtles(size_t symbolCount)
+{
+    const size_t progressMod = static_cast<size_t>(
+        (symbolCount / m_progressIncrease) * m_progressStep);
+
+    size_t progress = 0;
+    while(!m_threads.WaitFor(PROGRESS_INTERVAL_MS))
+    {
+        // Increase progress window
+        const size_t symbolsRead = m_symbolsRead;
+        while(progressMod > 0 && symbolsRead - progress >= progressMod)
+        {
+            progress += progressMod;
+            m_progress.Advance(m_progressStep);
+        }
+
+        // Check plugin is continuing
+        if(IsCancelled())
+        {
+            m_turtlesCancelled = true;
+            m_threads.Wait();
+            return false;
+        }
+    }
+    return !IsCancelled();
+}
+
+template<typename Rule> void TreeBuilder::NavigateTurtle(Rule& rule, 
+                                                         SkeletonPart& part,
+                                                         Turtle turtle)
+{
+    /* TURTLE COMMANDS
+    * F: draw forward
+    * G: move forward without drawing
+    * v: anticlockwise around z axis
+    * ^: clockwise around z axis
+    * >: clockwise around x axis
+    * <: anticlockwise around x axis
+    * -: anticlockwise around y axis
+    * +: clockwise around y axis
+    * L: create leaf
+    * [: Push turtle onto stack
+    * ]: Pop turtle off stack
+    */
+
+    const BranchData& trunk = m_parameters.trunk;
+    const BranchData& branch = m_parameters.branch;
+    std::deque<Turtle> stack;
+    const BranchData* values = (turtle.layerIndex == 0) ? &trunk : &branch;
+    RandomStream* random = &part.randoms[turtle.branchIndex];
+
+    char symbol = 0;
+    for(unsigned int progress = 1; rule.Next(symbol); ++progress)
+    {
+        Float3 result;
+        double angle = 0.0;
+
+        switch(symbol)
+        {
+            case 'F':
+            {
+                // Move forward with drawing 
+                result = DetermineForwardMovement(turtle, *random, values->forward, 
+                    values->forwardAngle, values->forwardVariance);
+
+                turtle.position += result;
+                turtle.orientation.Normalize();
+                
+                // Change radius
+                turtle.radius *= values->radiusDecrease;
+                if(turtle.radius < m_treedata.minimumRadius)
+                { 
+                    turtle.radius  = m_treedata.minimumRadius; 
+                }
+
+                // Add section to branch
+                part.positions.push_back(turtle.position);
+                part.radii.push_back(static_cast<float>(turtle.radius));
+                part.sectionBranches.push_back(turtle.branchIndex);
+                part.sectionCounts[turtle.branchIndex]++;
+                turtle.sectionAxis = turtle.position - turtle.sectionPosition;
+                turtle.sectionPosition = turtle.position;
+                turtle.sectionIndex++;
+                break;
+            }
+            case 'G':
+            {
+                // Move forward without drawing
+                result = DetermineForwardMovement(turtle, *random, values->forward, 
+                    values->forwardAngle, values->forwardVariance);
+
+                turtle.position += result;
+                break;
+            }
+            case '[':
+            {
+                // Push current tutle onto the stack
+                if(!TryKillBranch(rule, *random))
+                {
+                    // Give large branches to another worker
+                    turtle.branchEnded = true;
+                    if(!TrySplitBranch(rule, part, turtle))
+                    {
+                        stack.push_back(Turtle(turtle));
+                        BuildNewBranch(turtle, part, 
+                            NextRandomStream(part, turtle), &values);
+                        random = &part.randoms[turtle.branchIndex];
+                    }
+                }
+                break;
+            }
+            case ']':
+            {
+                // Pop back tutle from stack
+                if(stack.size() > 0)
+                {
+                    turtle = stack[stack.size()-1];
+                    stack.pop_back();
+                    values = (turtle.layerIndex == 0) ? &trunk : &branch;
+                    random = &part.randoms[turtle.branchIndex];
+                }
+                break;
+            }
+            case '+':
+            {
+                // Rotate positive Y
+                angle = random->Signed();
+                turtle.orientation.RotateYLocal(static_cast<float>(
+                    DegToRad(values->angle + (values->angleVariance * angle))));
+                break;
+            }
+            case '-':
+            {
+                // Rotate negative y
+                angle = random->Signed();
+                turtle.orientation.RotateYLocal(static_cast<float>(
+                    DegToRad(-values->angle + (values->angleVariance * angle))));
+                break;
+            }
+            case '>':
+            {
+                // Rotate positive x
+                angle = random->Signed();
+                turtle.orientation.RotateXLocal(static_cast<float>(
+                    DegToRad(values->angle + (values->angleVariance * angle))));
+                break;
+            }
+            case '<':
+            {
+                // Rotate negative x
+                angle = random->Signed();
+                turtle.orientation.RotateXLocal(static_cast<float>(
+                    DegToRad(-values->angle + (values->angleVariance * angle))));
+                break;
+            }
+            case '^':
+            {
+                // Rotate positive z
+                angle = random->Signed();
+                turtle.orientation.RotateZLocal(static_cast<float>(
+                    DegToRad(values->angle + (values->angleVariance * angle))));
+                break;
+            }
+            case 'v':
+            {
+                // Rotate negative z
+                angle = random->Signed();
+                turtle.orientation.RotateZLocal(static_cast<float>(
+                    DegToRad(-values->angle + (values->angleVariance * angle))));
+                break;
+            }
+            case 'L':
+            {
+                // Create a leaf
+                if(m_leafdata.treeHasLeaves 
+                   && (turtle.layerIndex != 0)
+                   && (turtle.layerIndex >= static_cast<int>(m_leafdata.leafLayer)) 
+                   && (turtle.sectionIndex != 0))
+                {
+                    part.leaves.push_back(Leaf(turtle.position, turtle.sectionAxis.GetNormalized(), 
+                        turtle.layerIndex, static_cast<float>(turtle.radius)));
+                }
+                break;
+            }
+        }
+
+        // Report progress and check plugin is continuing
+        if(progress == PROGRESS_SYMBOLS)
+        {
+            progress = 0;
+            m_symbolsRead += PROGRESS_SYMBOLS;
+            if(m_turtlesCancelled)
+            {
+                return;
+            }
+        }
+    }
+}
+
+bool TreeBuilder::TrySplitBranch(RuleReader& rule, 
+                                 SkeletonPart& part, 
+                                 const Turtle& turtle)
+{
+    if(rule.BranchLength() < m_splitSymbols)
+    {
+        return false;
+    }
+
+    part.splits.push_back(SkeletonPart::Split());
+    SkeletonPart::Split& split = part.splits.back();
+    split.branchCount = part.parents.size();
+    split.leafCount = part.leaves.size();
+    split.part = &m_workspace.AcquirePart();
+
+    // Start the branch in the new part with the turtle as it is now
+    SkeletonPart* splitPart = split.part;
+    Turtle splitTurtle(turtle);
+    const BranchData* values = (turtle.layerIndex == 0) ? 
+        &m_parameters.trunk : &m_parameters.branch;
+    BuildNewBranch(splitTurtle, *splitPart, NextRandomStream(part, turtle), &values);
+
+    auto splitRule = std::make_shared<RuleReader>(rule.SplitBranch());
+    m_threads.Push([=]()
+    {
+        NavigateTurtle(*splitRule, *splitPart, splitTurtle);
+    });
+    return true;
+}
+
+bool TreeBuilder::TrySplitBranch(RuleStream&, 
+                                 SkeletonPart&, 
+                                 const Turtle&)
+{
+    // Symbols are only known as they are derived
+    return false;
+}
+
+void TreeBuilder::MergeSkeleton(SkeletonPart& part, const std::vector<int>* parentIndices)
+{
+    Skeleton& tree = m_skeleton;
+    std::vector<int> indices(part.parents.size());
+    size_t branchIndex = 0;
+    size_t leafIndex = 0;
+
+    auto sectionTotal = [&tree]()
+    {
+        return tree.sectionStarts.empty() ? 0 : 
+            tree.sectionStarts.back() + tree.sectionCounts.back();
+    };
+
+    auto merge = [&](size_t branchCount, size_t leafCount)
+    {
+        for(; branchIndex < branchCount; ++branchIndex)
+        {
+            int parent = part.parents[branchIndex];
+            if(parent >= 0)
+            {
+                parent = (branchIndex == 0 && parentIndices != nullptr) ?
+                    (*parentIndices)[parent] : indices[parent];
+            }
+
+            indices[branchIndex] = static_cast<int>(tree.BranchCount());
+            tree.sectionStarts.push_back(sectionTotal());
+            tree.sectionCounts.push_back(part.sectionCounts[branchIndex]);
+            tree.parents.push_back(parent);
+            tree.layers.push_back(part.layers[branchIndex]);
+        }
+
+        tree.positions.resize(sectionTotal());
+        tree.radii.resize(sectionTotal());
+        m_leaves.insert(m_leaves.end(), part.leaves.begin() + leafIndex, 
+            part.leaves.begin() + leafCount);
+        leafIndex = leafCount;
+    };
+
+    // Splits are merged where they occured to keep the order of a serial build.
+    // A single turtle creates branches depth first so no renumbering is needed
+    for(SkeletonPart::Split& split : part.splits)
+    {
+        merge(split.branchCount, split.leafCount);
+        MergeSkeleton(*split.part, &indices);
+    }
+    merge(part.parents.size(), part.leaves.size());
+
+    // Group the sections by branch now that every branch has its range
+    std::vector<int> next(indices.size());
+    for(unsigned int i = 0; i < indices.size(); ++i)
+    {
+        next[i] = tree.sectionStarts[indices[i]];
+    }
+
+    for(unsigned int i = 0; i < part.sectionBranches.size(); ++i)
+    {
+        const int section = next[part.sectionBranches[i]]++;
+        tree.positions[section] = part.positions[i];
+        tree.radii[section] = part.radii[i];
+    }
+
+    m_meshdata.maxLayers = std::max(m_meshdata.maxLayers, part.maxLayers);
+}
+
+void TreeBuilder::BuildHierarchy(Skeleton& tree) const
+{
+    const int branchCount = static_cast<int>(tree.BranchCount());
+
+    // Count the children of each branch then place them after their siblings
+    tree.childStarts.assign(branchCount + 1, 0);
+    for(int i = 1; i < branchCount; ++i)
+    {
+        tree.childStarts[tree.parents[i] + 1]++;
+    }
+    for(int i = 0; i < branchCount; ++i)
+    {
+        tree.childStarts[i + 1] += tree.childStarts[i];
+    }
+
+    std::vector<int> next(tree.childStarts.begin(), tree.childStarts.end() - 1);
+    tree.children.resize(tree.childStarts[branchCount]);
+    for(int i = 1; i < branchCount; ++i)
+    {
+        tree.children[next[tree.parents[i]]++] = i;
+    }
+
+    // Children always follow their parent so subtrees close from the last branch back
+    tree.subtreeEnds.assign(branchCount, 0);
+    for(int i = branchCount - 1; i >= 0; --i)
+    {
+        tree.subtreeEnds[i] = std::max(tree.subtreeEnds[i], i + 1);
+        if(tree.parents[i] >= 0)
+        {
+            tree.subtreeEnds[tree.parents[i]] = std::max(
+                tree.subtreeEnds[tree.parents[i]], tree.subtreeEnds[i]);
+        }
+    }
+}
+
+void TreeBuilder::CompileRules()
+{
+    // Compile the rules into a direct symbol lookup
+    m_rules.Clear();
+    m_rules.SetSeed(m_treedata.seed);
+    m_rules.SetBranchDeath(m_treedata.pruneBranches ? 
+        m_treedata.branchDeathProbability : 0);
+    for(int ruleNum = 0; ruleNum < TreeParameters::RULE_NUMBER; ++ruleNum)
+    {
+        if(!m_parameters.ruleIDs[ruleNum].empty())
+        {
+            m_rules.AddRule(m_parameters.ruleIDs[ruleNum][0],
+                m_parameters.ruleStrings[ruleNum], m_parameters.ruleChances[ruleNum]);
+        }
+    }
+}
+
+bool TreeBuilder::CreateRuleString()
+{
+    std::string& temprule = m_workspace.scratchRule;
+    for(unsigned int i = 0; i < m_parameters.iterations; ++i)
+    {
+        m_rules.Rewrite(m_rule, temprule, i, m_threads);
+        m_rule.swap(temprule);
+
+        if(IsCancelled())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Rule> bool TreeBuilder::TryKillBranch(Rule& rule, RandomStream& random)
+{
+    // Branches have already been pruned while deriving
+    if(m_treedata.pruneBranches)
+    {
+        return false;
+    }
+
+    // Check probability of branch dying
+    if(random.Generate(0, 100) < static_cast<int>(m_treedata.branchDeathProbability))
+    {
+        rule.SkipBranch();
+        return true;
+    }
+    return false;
+}
+
+RandomStream TreeBuilder::NextRandomStream(SkeletonPart& part, const Turtle& turtle) const
+{
+    const int parent = turtle.branchIndex;
+    return part.randoms[parent].Split(part.childCounts[parent]++);
+}
+
+void TreeBuilder::BuildNewBranch(Turtle& turtle, 
+                                 SkeletonPart& part, 
+                                 const RandomStream& random,
+                                 const BranchData** values)
+{
+    // Change values used if moving from trunk to branch
+    if(turtle.layerIndex == 0)
+    {
+        *values = &m_parameters.branch;
+    }
+
+    // Change radius
+    turtle.radius *= m_treedata.branchRadiusDecrease;
+    if(turtle.radius < m_treedata.minimumRadius)
+    { 
+        turtle.radius = m_treedata.minimumRadius;
+    }
+    
+    // Start a new branch
+    turtle.layerIndex++;
+    part.maxLayers = std::max(part.maxLayers, turtle.layerIndex); 
+    turtle.branchParent = turtle.branchIndex;
+    turtle.branchIndex = static_cast<int>(part.parents.size());
+    turtle.branchEnded = false;
+    turtle.sectionPosition = turtle.position;
+
+    part.positions.push_back(turtle.position);
+    part.radii.push_back(static_cast<float>(turtle.radius));
+    part.sectionBranches.push_back(turtle.branchIndex);
+    part.sectionCounts.push_back(1);
+    part.parents.push_back(turtle.branchParent);
+    part.layers.push_back(turtle.layerIndex);
+    part.randoms.push_back(random);
+    part.childCounts.push_back(0);
+    turtle.sectionIndex = 0;
+}
+
+Float3 TreeBuilder::DetermineForwardMovement(const Turtle& turtle, 
+                                               RandomStream& random,
+                                               double forward, 
+                                               double angle, 
+                                               double variation) const
+{
+    const double x = random.Signed();
+    const double y = random.Signed();
+    const double z = random.Signed();
+    const float length = random.Signed();
+
+    // Determine direction, axis must be normalized
+    const Quaternion rotation = 
+        Quaternion::CreateRotateZ(static_cast<float>(DegToRad(angle*z))) *
+        Quaternion::CreateRotateX(static_cast<float>(DegToRad(angle*x))) *
+        Quaternion::CreateRotateY(static_cast<float>(DegToRad(angle*y)));
+
+    Float3 result = rotation.Rotate(turtle.orientation.Forward());
+
+    // Determine forward amount
+    result *= static_cast<float>(forward + (variation * length));
+    return result;
+}
+
+bool TreeBuilder::CreateCurves(TreeOutput& output)
+{
+    m_progress.Describe("Meshing:");
+    unsigned int progressMod = static_cast<unsigned int>(
+        (m_skeleton.BranchCount() / m_progressIncrease) * m_progressStep); 
+
+    // Create each branch
+    std::vector<Float3>& points = m_workspace.points;
+    for(unsigned int j = 0, progress = 0; j < m_skeleton.BranchCount(); ++j, ++progress)
+    {
+        const int sectionCount = m_skeleton.sectionCounts[j];
+        if(sectionCount > 1)
+        {
+            const auto start = m_skeleton.positions.begin() + m_skeleton.sectionStarts[j];
+            points.assign(start, start + sectionCount);
+            output.AddCurve(points, m_treedata.treename + "_B" + std::to_string(j), m_skeleton.layers[j]);
+        }
+
+        if(progress >= progressMod) 
+        { 
+            progress = 0; 
+            m_progress.Advance(m_progressStep); 
+        }
+
+        if(IsCancelled())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int TreeBuilder::DiskFaces(int layer, int level) const
+{
+    if(layer == 0 && level == 0)
+    {
+        return static_cast<int>(m_meshdata.trunkfaces);
+    }
+
+    // Each level of detail divides the faces of the full tree
+    const int MAX_FACES = 3;
+    int facenumber = layer == 0 ? static_cast<int>(m_meshdata.trunkfaces) :
+        m_meshdata.branchfaces - (m_meshdata.faceDecrease*layer);
+    facenumber /= level + 1;
+    if(facenumber < MAX_FACES)
+    { 
+        facenumber = MAX_FACES; 
+    }
+    return facenumber;
+}
+
+int TreeBuilder::LevelCount() const
+{
+    return std::max(1, static_cast<int>(m_meshdata.lods));
+}
+
+void TreeBuilder::CreateLevelOfDetail(int level, Skeleton& lod, std::vector<int>& branches) const
+{
+    lod.Clear();
+    branches.clear();
+
+    // Branches thinner than the thinnest branch grown for each level are removed
+    float thinnest = std::numeric_limits<float>::max();
+    for(unsigned int j = 1; j < m_skeleton.BranchCount(); ++j)
+    {
+        if(m_skeleton.sectionCounts[j] > 0)
+        {
+            thinnest = std::min(thinnest, m_skeleton.radii[m_skeleton.sectionStarts[j]]);
+        }
+    }
+    const float minimumRadius = thinnest * std::pow(LOD_RADIUS_STEP, static_cast<float>(level));
+    const float straightCos = static_cast<float>(cos(DegToRad(LOD_STRAIGHT_ANGLE * level)));
+
+    const int branchCount = static_cast<int>(m_skeleton.BranchCount());
+    for(int j = 0; j < branchCount;)
+    {
+        const int start = m_skeleton.sectionStarts[j];
+        const int count = m_skeleton.sectionCounts[j];
+        if(j > 0 && count > 0 && m_skeleton.radii[start] < minimumRadius)
+        {
+            // Removing a branch removes all the branches growing from it
+            j = m_skeleton.subtreeEnds[j];
+            continue;
+        }
+
+        // Parents come before their children so are always kept before them
+        const int parent = m_skeleton.parents[j];
+        lod.parents.push_back(parent < 0 ? -1 : static_cast<int>(std::lower_bound(
+            branches.begin(), branches.end(), parent) - branches.begin()));
+        lod.layers.push_back(m_skeleton.layers[j]);
+        lod.sectionStarts.push_back(static_cast<int>(lod.positions.size()));
+        branches.push_back(j);
+
+        // Keep the ends and each section where the branch bends away from the last section kept
+        const Float3* positions = &m_skeleton.positions[start];
+        const float* radii = &m_skeleton.radii[start];
+        for(int i = 0; i < count; ++i)
+        {
+            if(i > 0 && i < count - 1)
+            {
+                const Float3 run = positions[i] - lod.positions.back();
+                const Float3 next = positions[i+1] - positions[i];
+                if(run.Dot(next) >= straightCos * run.Length() * next.Length())
+                {
+                    continue;
+                }
+            }
+            lod.positions.push_back(positions[i]);
+            lod.radii.push_back(radii[i]);
+        }
+        lod.sectionCounts.push_back(static_cast<int>(lod.positions.size()) - lod.sectionStarts.back());
+        ++j;
+    }
+
+    BuildHierarchy(lod);
+}
+
+TreeEstimate TreeBuilder::Estimate() const
+{
+    TreeEstimate estimate;
+    estimate.symbols = m_symbolCount;
+    estimate.branches = m_skeleton.BranchCount();
+    estimate.sections = m_skeleton.SectionCount();
+    estimate.leaves = m_leaves.size();
+
+    // The tree and each layer with its branches and leaves groups
+    const int layers = LayerCount();
+    estimate.groupNodes = 1 + layers * (1 + (m_leafdata.treeHasLeaves ? 1 : 0) + 
+        (m_meshdata.createAsCurves ? 0 : 1));
+
+    // Branches with a single section are never meshed. Curves have no levels of detail
+    const int levels = m_meshdata.createAsCurves ? 1 : LevelCount();
+    for(int level = 0; level < levels; ++level)
+    {
+        if(level > 0)
+        {
+            CreateLevelOfDetail(level, m_workspace.lodSkeleton, m_workspace.lodBranches);
+        }
+
+        const Skeleton& skeleton = level > 0 ? m_workspace.lodSkeleton : m_skeleton;
+        std::vector<bool> meshedLayers(layers, false);
+        size_t meshedBranches = 0;
+        for(unsigned int j = 0; j < skeleton.BranchCount(); ++j)
+        {
+            const size_t sections = skeleton.sectionCounts[j];
+            const int layer = skeleton.layers[j];
+            if(sections <= 1)
+            {
+                continue;
+            }
+
+            if(m_meshdata.createAsCurves)
+            {
+                ++estimate.curveNodes;
+                estimate.branchVertices += sections;
+                continue;
+            }
+
+            const MeshSize size = BranchMeshSize(skeleton, static_cast<int>(j), level);
+            estimate.branchVertices += size.vertices;
+            estimate.branchFaces += size.faces;
+            meshedLayers[layer] = true;
+            ++meshedBranches;
+        }
+
+        if(!m_meshdata.createAsCurves)
+        {
+            const size_t meshedLayerCount = std::count(meshedLayers.begin(), meshedLayers.end(), true);
+            switch(m_meshdata.meshMode)
+            {
+            case MESH_PER_TREE:
+                estimate.meshNodes += meshedLayerCount > 0 ? 1 : 0;
+                break;
+            case MESH_PER_LAYER:
+                estimate.meshNodes += meshedLayerCount;
+                break;
+            default:
+                estimate.meshNodes += meshedBranches;
+                break;
+            }
+        }
+    }
+
+    if(!m_leafdata.treeHasLeaves)
+    {
+        return estimate;
+    }
+
+    const size_t leafVertices = m_leafdata.bendAmount == 0 ? 4 : 6;
+    const size_t leafFaces = m_leafdata.bendAmount == 0 ? 1 : 2;
+
+    if(m_leafdata.leafMode == LEAF_INSTANCED)
+    {
+        // Only the prototypes are meshed
+        LeafInstancer instancer(static_cast<float>(m_leafdata.width), 
+            static_cast<float>(m_leafdata.height), static_cast<float>(m_leafdata.widthVariance), 
+            static_cast<float>(m_leafdata.heightVariance), static_cast<float>(m_leafdata.bendAmount));
+
+        const size_t prototypes = instancer.PrototypeCount();
+        estimate.instances = m_leaves.size();
+        estimate.instancerNodes = 1;
+        estimate.meshNodes += prototypes;
+        estimate.leafVertices = prototypes * leafVertices;
+        estimate.leafFaces = prototypes * leafFaces;
+        return estimate;
+    }
+
+    estimate.leafVertices = m_leaves.size() * leafVertices;
+    estimate.leafFaces = m_leaves.size() * leafFaces;
+
+    if(m_leafdata.leafMode == LEAF_PER_LAYER)
+    {
+        std::vector<bool> leafLayers(layers, false);
+        for(const Leaf& leaf : m_leaves)
+        {
+            leafLayers[leaf.layer] = true;
+        }
+        estimate.meshNodes += std::count(leafLayers.begin(), leafLayers.end(), true);
+    }
+    else
+    {
+        estimate.meshNodes += m_leaves.size();
+    }
+    return estimate;
+}
+
+bool TreeBuilder::CreateMeshes(TreeOutput& output)
+{
+    m_progress.Describe("Meshing:");
+
+    // Lower levels of detail are reduced from the tree, leaving the leaves shared by all levels
+    size_t progress = 0;
+    for(int level = 0; level < LevelCount(); ++level)
+    {
+        const bool reduced = level > 0;
+        if(reduced)
+        {
+            CreateLevelOfDetail(level, m_workspace.lodSkeleton, m_workspace.lodBranches);
+        }
+
+        if(!CreateBranchMeshes(reduced ? m_workspace.lodSkeleton : m_skeleton,
+            reduced ? &m_workspace.lodBranches : nullptr, level, progress, output))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TreeBuilder::CreateBranchMeshes(const Skeleton& skeleton,
+                                     const std::vector<int>* branches,
+                                     int level,
+                                     size_t& progress,
+                                     TreeOutput& output)
+{
+    const size_t progressMod = static_cast<size_t>(
+        ((m_skeleton.BranchCount() * LevelCount()) / m_progressIncrease) * m_progressStep); 
+
+    // Meshes of each level are named apart when there is more than one
+    const std::string suffix = LevelCount() > 1 ? "_LOD" + std::to_string(level) : "";
+
+    // Create the disks
+    std::vector<Disk>& disk = m_workspace.Disks(LayerCount());
+    for(int j = 0; j < LayerCount(); ++j)
+    {
+        const int facenumber = DiskFaces(j, level);
+        const float angle = 360.0f / facenumber;
+        for(int i = 0; i < facenumber; ++i)
+        {
+            disk[j].points.push_back(Float3(
+                static_cast<float>(cos(DegToRad(i*angle))), 0, 
+                static_cast<float>(sin(DegToRad(i*angle)))));
+        }
+    }
+
+    CreateRingFrames(skeleton);
+
+    // Branches are merged into one mesh per layer, one for the tree or kept 
+    // separate where each branch of a batch is computed into its own mesh
+    const size_t branchCount = skeleton.BranchCount();
+    const bool mergeLayers = m_meshdata.meshMode == MESH_PER_LAYER;
+    const bool mergeTree = m_meshdata.meshMode == MESH_PER_TREE;
+    const bool merged = mergeLayers || mergeTree;
+    std::vector<MeshBuffer>& meshes = m_workspace.BranchMeshes(mergeLayers ? 
+        LayerCount() : (mergeTree ? 1 : std::min(branchCount, MESH_BATCH)));
+    std::vector<std::vector<int>>& branchFaces = m_workspace.BranchFaces(merged ? meshes.size() : 1);
+
+    // Share the faces and uvs between branches of the same shape
+    TopologyCache& cache = m_workspace.topologies;
+    std::vector<int>& topologies = m_workspace.branchTopologies;
+    topologies.resize(branchCount);
+    for(unsigned int j = 0; j < branchCount; ++j)
+    {
+        if(skeleton.sectionCounts[j] > 1)
+        {
+            const int branch = static_cast<int>(j);
+            const int layer = skeleton.layers[j];
+            topologies[j] = cache.Acquire(skeleton.sectionCounts[j], DiskFaces(layer, level),
+                skeleton.ChildCount(branch) == 0 && m_meshdata.capEnds, 
+                [&](MeshBuffer& topology) { CreateTopology(skeleton, branch, level, disk[layer], topology); });
+        }
+    }
+
+    if(m_profiler)
+    {
+        m_profiler->Count("topologies", cache.Size());
+    }
+
+    // Merged meshes hold the uvs of each shape once for all its branches, like merged leaves.
+    // Each branch is given its place in the merged meshes so they can be filled in any order
+    std::vector<MeshSize>& offsets = m_workspace.offsets;
+    if(merged)
+    {
+        const size_t shapes = cache.Size();
+        std::vector<int> uvStarts(meshes.size() * shapes, -1);
+        std::vector<MeshSize> sizes(meshes.size());
+        offsets.resize(branchCount);
+        for(unsigned int j = 0; j < branchCount; ++j)
+        {
+            if(skeleton.sectionCounts[j] > 1)
+            {
+                const int branch = static_cast<int>(j);
+                const int meshIndex = mergeLayers ? skeleton.layers[j] : 0;
+                int& uvStart = uvStarts[(meshIndex * shapes) + topologies[j]];
+                if(uvStart < 0)
+                {
+                    uvStart = static_cast<int>(sizes[meshIndex].uvs);
+                    sizes[meshIndex].uvs += cache.Get(topologies[j]).uCoord.size();
+                }
+
+                MeshSize size = BranchMeshSize(skeleton, branch, level);
+                size.uvs = 0;
+                offsets[j] = sizes[meshIndex];
+                offsets[j].uvs = uvStart;
+                branchFaces[meshIndex].push_back(branches ? (*branches)[j] : branch);
+                branchFaces[meshIndex].push_back(static_cast<int>(sizes[meshIndex].faces));
+                branchFaces[meshIndex].push_back(static_cast<int>(size.faces));
+                sizes[meshIndex] += size;
+            }
+        }
+
+        for(unsigned int i = 0; i < meshes.size(); ++i)
+        {
+            meshes[i].Resize(sizes[i]);
+            for(unsigned int shape = 0; shape < shapes; ++shape)
+            {
+                if(uvStarts[(i * shapes) + shape] >= 0)
+                {
+                    CopyUVs(cache.Get(shape), meshes[i], uvStarts[(i * shapes) + shape]);
+                }
+            }
+        }
+    }
+
+    for(size_t batch = 0; batch < branchCount; batch += MESH_BATCH)
+    {
+        const size_t batchEnd = std::min(branchCount, batch + MESH_BATCH);
+
+        // Compute the geometry of the batch across the workers
+        m_threads.ParallelFor(batchEnd - batch, MIN_MESH_CHUNK, [&](size_t, size_t begin, size_t end)
+        {
+            for(size_t j = batch + begin; j < batch + end; ++j)
+            {
+                if(skeleton.sectionCounts[j] > 1)
+                {
+                    const int branch = static_cast<int>(j);
+                    const int layer = skeleton.layers[j];
+                    MeshBuffer& mesh = merged ? meshes[mergeLayers ? layer : 0] : meshes[j - batch];
+                    if(!merged)
+                    {
+                        mesh.Resize(BranchMeshSize(skeleton, branch, level));
+                        CopyUVs(cache.Get(topologies[j]), mesh, 0);
+                    }
+                    CreateMesh(skeleton, branch, disk[layer], mesh, merged ? offsets[j] : MeshSize());
+                }
+            }
+        });
+
+        // Commit the separate branches in order
+        if(!merged)
+        {
+            for(size_t j = batch; j < batchEnd; ++j)
+            {
+                if(skeleton.sectionCounts[j] > 1)
+                {
+                    const size_t treeBranch = branches ? (*branches)[j] : j;
+                    output.AddMesh(meshes[j - batch], m_treedata.treename + "_BRN" + 
+                        std::to_string(treeBranch) + suffix, skeleton.layers[j], false, branchFaces[0]);
+                }
+            }
+        }
+
+        // Advance progress bar
+        progress += batchEnd - batch;
+        while(progressMod > 0 && progress >= progressMod)
+        { 
+            progress -= progressMod; 
+            m_progress.Advance(m_progressStep); 
+        }
+
+        if(IsCancelled())
+        {
+            return false;
+        }
+    }
+
+    // Commit the merged meshes
+    if(merged)
+    {
+        for(unsigned int i = 0; i < meshes.size(); ++i)
+        {
+            if(meshes[i].polycounts.empty())
+            {
+                continue;
+            }
+
+            if(mergeTree)
+            {
+                output.AddMesh(meshes[i], m_treedata.treename + "_BRN" + suffix, -1, false, branchFaces[i]);
+            }
+            else
+            {
+                output.AddMesh(meshes[i], m_treedata.treename + "_Layer" + 
+                    std::to_string(i) + "_BRN" + suffix, i, false, branchFaces[i]);
+            }
+        }
+    }
+    return true;
+}
+
+bool TreeBuilder::CreateLeaves(TreeOutput& output)
+{
+    m_progress.Describe("Leafing:");
+    const size_t progressMod = static_cast<size_t>(
+        (m_leaves.size() / m_progressIncrease) * m_progressStep);
+
+    int vertno = 0;
+    float bleed = static_cast<float>(m_fxdata.uvBleedSpace);
+    if(m_leafdata.bendAmount == 0)
+    {
+        vertno = 4;
+        m_leafTopology.polycounts.push_back(4);
+
+        //Create indices (face1)
+        m_leafTopology.indices.push_back(0);    
+        m_leafTopology.indices.push_back(1);    
+        m_leafTopology.indices.push_back(3);    
+        m_leafTopology.indices.push_back(2);
+
+        // Create the uvs (face1)
+        m_leafTopology.uCoord.push_back(0.0f);   
+        m_leafTopology.vCoord.push_back(0.0f);
+        m_leafTopology.uCoord.push_back(1.0f);   
+        m_leafTopology.vCoord.push_back(0.0f); 
+        m_leafTopology.uCoord.push_back(1.0f); 
+        m_leafTopology.vCoord.push_back(1.0f); 
+        m_leafTopology.uCoord.push_back(0.0f);  
+        m_leafTopology.vCoord.push_back(1.0f); 
+        m_leafTopology.uvIDs.push_back(0);  
+        m_leafTopology.uvIDs.push_back(1);  
+        m_leafTopology.uvIDs.push_back(2);  
+        m_leafTopology.uvIDs.push_back(3);
+    }
+    else
+    {
+        vertno = 6;
+        m_leafTopology.polycounts.push_back(4); 
+        m_leafTopology.polycounts.push_back(4);
+
+        // Create indices for face 1
+        m_leafTopology.indices.push_back(0);    
+        m_leafTopology.indices.push_back(1);    
+        m_leafTopology.indices.push_back(3);    
+        m_leafTopology.indices.push_back(2);
+
+        // Create indices for face 2
+        m_leafTopology.indices.push_back(2);    
+        m_leafTopology.indices.push_back(3);    
+        m_leafTopology.indices.push_back(5);    
+        m_leafTopology.indices.push_back(4); 
+
+        // Create the uvs
+        m_leafTopology.uCoord.push_back(0.0f + bleed);  
+        m_leafTopology.vCoord.push_back(0.0f + bleed);
+        m_leafTopology.uCoord.push_back(1.0f - bleed); 
+        m_leafTopology.vCoord.push_back(0.0f + bleed); 
+        m_leafTopology.uCoord.push_back(1.0f - bleed); 
+        m_leafTopology.vCoord.push_back(0.5f); 
+        m_leafTopology.uCoord.push_back(0.0f + bleed);  
+        m_leafTopology.vCoord.push_back(0.5f); 
+        m_leafTopology.uCoord.push_back(1.0f - bleed);  
+        m_leafTopology.vCoord.push_back(1.0f - bleed); 
+        m_leafTopology.uCoord.push_back(0.0f + bleed);  
+        m_leafTopology.vCoord.push_back(1.0f - bleed); 
+
+        // Face1
+        m_leafTopology.uvIDs.push_back(0);  
+        m_leafTopology.uvIDs.push_back(1);  
+        m_leafTopology.uvIDs.push_back(2);  
+        m_leafTopology.uvIDs.push_back(3);
+
+        // Face2
+        m_leafTopology.uvIDs.push_back(3);  
+        m_leafTopology.uvIDs.push_back(2);  
+        m_leafTopology.uvIDs.push_back(4);  
+        m_leafTopology.uvIDs.push_back(5);
+    }
+
+    // Generate the random values for all leaves at once, each leaf 
+    // reads from its own slice so leaves can be created in any order
+    std::vector<float>& randoms = m_workspace.randoms;
+    randoms.resize(m_leaves.size() * LEAF_RANDOMS);
+    RandomStream(m_treedata.seed, LEAF_STREAM).Fill(randoms.data(), randoms.size());
+
+    if(m_leafdata.leafMode == LEAF_INSTANCED)
+    {
+        return CreateLeafInstances(randoms, output);
+    }
+
+    // Merged leaves share the same uvs and only offset the vertex indices,
+    // separate leaves of a batch are each computed into their own mesh
+    const size_t leafCount = m_leaves.size();
+    const bool mergeLayers = m_leafdata.leafMode == LEAF_PER_LAYER;
+    std::vector<MeshBuffer>& meshes = m_workspace.LeafMeshes(
+        mergeLayers ? LayerCount() : std::min(leafCount, MESH_BATCH));
+
+    MeshSize leafSize;
+    leafSize.vertices = vertno;
+    leafSize.faces = m_leafTopology.polycounts.size();
+    leafSize.indices = m_leafTopology.indices.size();
+
+    // Give each leaf its place in the merged meshes so they can be filled in any order
+    std::vector<MeshSize>& offsets = m_workspace.offsets;
+    std::vector<MeshSize> sizes(meshes.size(), leafSize);
+    if(mergeLayers)
+    {
+        offsets.resize(leafCount);
+        std::fill(sizes.begin(), sizes.end(), MeshSize());
+        for(unsigned int i = 0; i < leafCount; ++i)
+        {
+            offsets[i] = sizes[m_leaves[i].layer];
+            sizes[m_leaves[i].layer] += leafSize;
+        }
+    }
+
+    for(unsigned int i = 0; i < meshes.size(); ++i)
+    {
+        sizes[i].uvs = m_leafTopology.uCoord.size();
+        meshes[i].Resize(sizes[i]);
+        meshes[i].uCoord = m_leafTopology.uCoord;
+        meshes[i].vCoord = m_leafTopology.vCoord;
+    }
+
+    size_t progress = 0;
+    for(size_t batch = 0; batch < leafCount; batch += MESH_BATCH)
+    {
+        const size_t batchEnd = std::min(leafCount, batch + MESH_BATCH);
+
+        // Compute the geometry of the batch across the workers
+        m_threads.ParallelFor(batchEnd - batch, MIN_LEAF_CHUNK, [&](size_t, size_t begin, size_t end)
+        {
+            for(size_t i = batch + begin; i < batch + end; ++i)
+            {
+                Leaf& leaf = m_leaves[i];
+                MeshBuffer& mesh = mergeLayers ? meshes[leaf.layer] : meshes[i - batch];
+                const MeshSize offset = mergeLayers ? offsets[i] : MeshSize();
+                CreateLeafVertices(leaf, &randoms[i * LEAF_RANDOMS], &mesh.vertices[offset.vertices]);
+                WriteLeaf(offset, mesh);
+            }
+        });
+
+        // Commit the separate leaves in order
+        if(!mergeLayers)
+        {
+            for(size_t i = batch; i < batchEnd; ++i)
+            {
+                output.AddMesh(meshes[i - batch], m_treedata.treename + "_LVS" + std::to_string(i), 
+                    m_leaves[i].layer, true, std::vector<int>());
+            }
+        }
+
+        // Advance progress bar
+        progress += batchEnd - batch;
+        while(progressMod > 0 && progress >= progressMod)
+        { 
+            progress -= progressMod; 
+            m_progress.Advance(m_progressStep); 
+        }
+
+        if(IsCancelled())
+        {
+            return false;
+        }
+    }
+
+    // Commit the merged meshes
+    if(mergeLayers)
+    {
+        for(unsigned int i = 0; i < meshes.size(); ++i)
+        {
+            if(!meshes[i].polycounts.empty())
+            {
+                output.AddMesh(meshes[i], m_treedata.treename + "_Layer" + 
+                    std::to_string(i) + "_LVS", i, true, std::vector<int>());
+            }
+        }
+    }
+    return true;
+}
+
+bool TreeBuilder::CreateLeafInstances(const std::vector<float>& randoms, TreeOutput& output)
+{
+    const size_t progressMod = static_cast<size_t>(
+        (m_leaves.size() / m_progressIncrease) * m_progressStep);
+
+    LeafInstancer instancer(static_cast<float>(m_leafdata.width), 
+        static_cast<float>(m_leafdata.height), static_cast<float>(m_leafdata.widthVariance), 
+        static_cast<float>(m_leafdata.heightVariance), static_cast<float>(m_leafdata.bendAmount));
+
+    // Prototypes share the leaf topology
+    LeafInstanceSink& sink = output.AddLeafInstancer(m_leafTopology, m_treedata.treename + "_LVS");
+    instancer.CreatePrototypes(sink);
+
+    // Compute the transforms across the workers then hand them over at once
+    std::vector<LeafInstance>& instances = m_workspace.instances;
+    instances.resize(m_leaves.size());
+    size_t progress = 0;
+    for(size_t batch = 0; batch < m_leaves.size(); batch += MESH_BATCH)
+    {
+        const size_t batchEnd = std::min(m_leaves.size(), batch + MESH_BATCH);
+        m_threads.ParallelFor(batchEnd - batch, MIN_LEAF_CHUNK, [&](size_t, size_t begin, size_t end)
+        {
+            for(size_t i = batch + begin; i < batch + end; ++i)
+            {
+                Leaf& leaf = m_leaves[i];
+                instances[i] = instancer.CreateInstance(leaf.position, leaf.sectionAxis, 
+                    leaf.sectionRadius, &randoms[i * LEAF_RANDOMS]);
+
+                leaf.position = instances[i].position;
+            }
+        });
+
+        // Advance progress bar
+        progress += batchEnd - batch;
+        while(progressMod > 0 && progress >= progressMod)
+        { 
+            progress -= progressMod; 
+            m_progress.Advance(m_progressStep); 
+        }
+
+        if(IsCancelled())
+        {
+            return false;
+        }
+    }
+    sink.SetInstances(instances);
+    return true;
+}
+
+void TreeBuilder::CreateLeafVertices(Leaf& leaf, const float* random, Float3* vertices)
+{
+    // Create the verts
+    double angle = 360.0 * random[0];
+
+    float width = static_cast<float>(m_leafdata.width + 
+        (m_leafdata.widthVariance * random[1]));
+
+    float height = static_cast<float>(m_leafdata.height + 
+        (m_leafdata.heightVariance * random[2]));
+
+    Matrix transform = Matrix::CreateRotateArbitrary(
+        leaf.sectionAxis, static_cast<float>(DegToRad(angle)));
+
+    int vertno = 0;
+    if(m_leafdata.bendAmount != 0)
+    {
+        vertno = 6;
+        vertices[0].Set(-width/2, 0, 0);
+        vertices[1].Set(width/2, 0, 0);
+
+        vertices[2].Set(-width/2, static_cast<float>(
+            m_leafdata.bendAmount * random[3]), height/2);
+
+        vertices[3].Set(width/2, static_cast<float>(
+            m_leafdata.bendAmount * random[4]), height/2);
+
+        vertices[4].Set(-width/2, 0, height);
+        vertices[5].Set(width/2, 0, height);
+    }
+    else
+    {
+        vertno = 4;
+        vertices[0].Set(-width/2, 0, 0);
+        vertices[1].Set(width/2, 0, 0);
+        vertices[2].Set(-width/2, 0, height);
+        vertices[3].Set(width/2, 0, height);
+    }
+
+    // Move verts roughly outside branch
+    Float3 offset = transform * (vertices[3] - vertices[1]);
+    offset = (leaf.sectionAxis.Cross(offset)).Cross(leaf.sectionAxis);
+    offset.Normalize();
+    offset *= leaf.sectionRadius / 2.0f;
+    leaf.position += offset;
+
+    // Rotate and translate verts
+    transform.SetPosition(leaf.position);
+    TransformPoints(transform, vertices, vertices, vertno);
+}
+
+void TreeBuilder::WriteLeaf(const MeshSize& offset, MeshBuffer& mesh)
+{
+    std::copy(m_leafTopology.polycounts.begin(), m_leafTopology.polycounts.end(), 
+        &mesh.polycounts[offset.faces]);
+
+    const int vertOffset = static_cast<int>(offset.vertices);
+    const size_t indexCount = m_leafTopology.indices.size();
+    int* indices = &mesh.indices[offset.indices];
+    int* uvIDs = &mesh.uvIDs[offset.indices];
+    for(unsigned int i = 0; i < indexCount; ++i)
+    {
+        indices[i] = vertOffset + m_leafTopology.indices[i];
+        uvIDs[i] = m_leafTopology.uvIDs[i];
+    }
+}
+
+void TreeBuilder::CreateRingFrames(const Skeleton& skeleton)
+{
+    // Parents come before their children so their last frame is always ready
+    std::vector<RingFrame>& frames = m_workspace.frames;
+    frames.resize(skeleton.SectionCount());
+    for(unsigned int j = 0; j < skeleton.BranchCount(); ++j)
+    {
+        const int start = skeleton.sectionStarts[j];
+        const int count = skeleton.sectionCounts[j];
+        const int parent = skeleton.parents[j];
+        if(count == 0)
+        {
+            continue;
+        }
+
+        if(parent >= 0 && skeleton.sectionCounts[parent] > 0)
+        {
+            frames[start] = frames[skeleton.sectionStarts[parent] + skeleton.sectionCounts[parent] - 1];
+        }
+        else
+        {
+            frames[start].tangent.Set(0.0f, 1.0f, 0.0f);
+            frames[start].normal.Set(1.0f, 0.0f, 0.0f);
+        }
+
+        // Face the past axis at the tip or half way between the past and future axis
+        const Float3* positions = &skeleton.positions[start];
+        for(int i = 1; i < count; ++i)
+        {
+            Float3 tangent = positions[i] - positions[i-1];
+            if(i < count - 1)
+            {
+                tangent += positions[i+1] - positions[i];
+            }
+            frames[start + i] = TransportFrame(frames[start + i - 1], 
+                positions[i-1], positions[i], tangent);
+        }
+    }
+}
+
+MeshSize TreeBuilder::BranchMeshSize(const Skeleton& skeleton, int branch, int level) const
+{
+    // A ring for each section with a seam uv and a fan of faces around the cap
+    const size_t sections = skeleton.sectionCounts[branch];
+    const size_t faces = DiskFaces(skeleton.layers[branch], level);
+    const bool capped = skeleton.ChildCount(branch) == 0 && m_meshdata.capEnds;
+
+    MeshSize size;
+    size.vertices = (sections * faces) + (capped ? 1 : 0);
+    size.faces = ((sections - 1) * faces) + (capped ? faces : 0);
+    size.indices = ((sections - 1) * faces * 4) + (capped ? faces * 3 : 0);
+    size.uvs = (sections * (faces + 1)) + (capped ? faces + 1 : 0);
+    return size;
+}
+
+void TreeBuilder::CreateTopology(const Skeleton& skeleton,
+                                 int branch,
+                                 int level,
+                                 const Disk& disk,
+                                 MeshBuffer& topology) const
+{
+    // Only the faces and uvs are shared
+    MeshSize size = BranchMeshSize(skeleton, branch, level);
+    size.vertices = 0;
+    topology.Resize(size);
+
+    int* polycounts = topology.polycounts.data();
+    int* indices = topology.indices.data();
+    int* uvIDs = topology.uvIDs.data();
+    float* uCoord = topology.uCoord.data();
+    float* vCoord = topology.vCoord.data();
+
+    int facenumber = static_cast<int>(disk.points.size());
+    int sectionnumber = skeleton.sectionCounts[branch];
+
+    int pastindex = 0;
+    int index = 0;
+    int sIndex = 0;
+    int sPastindex = 0;
+    int uvPastindex = 0;
+    int uvIndex = 0;
+    int uvringnumber = facenumber+1;
+    float bleed = (float)m_fxdata.uvBleedSpace;
+
+    // Initial ring uvs
+    for(int j = 0; j < facenumber; ++j)
+    {
+        vCoord[j] = bleed;
+        uCoord[j] = ChangeRange(static_cast<float>(j), 0.0f,
+            static_cast<float>(facenumber), bleed,  1.0f - bleed);
+    }
+    uCoord[facenumber] = 1.0f - bleed;
+    vCoord[facenumber] = bleed;
+
+    // Other branch rings
+    for(int i = 1; i < sectionnumber; ++i)
+    {
+        sIndex = i * facenumber;
+        sPastindex = (i-1) * facenumber;
+        uvIndex = i * uvringnumber;
+        uvPastindex = (i-1) * uvringnumber;
+
+        // Find v coordinate
+        float vcoordinate = ChangeRange(static_cast<float>(i),
+            0.0f,static_cast<float>(sectionnumber-1),bleed,1.0f-bleed);
+
+        // For each vertex/face
+        float* ringU = &uCoord[i * uvringnumber];
+        float* ringV = &vCoord[i * uvringnumber];
+        int* ringPolycounts = &polycounts[(i-1) * facenumber];
+        int* ringIndices = &indices[(i-1) * facenumber * 4];
+        int* ringUVs = &uvIDs[(i-1) * facenumber * 4];
+        for(int j = 0; j < facenumber; ++j)
+        {
+            // Create vertex uvs
+            ringU[j] = uCoord[j];
+            ringV[j] = vcoordinate;
+
+            // Create faces
+            ringPolycounts[j] = 4;
+            index = sIndex + j;
+            pastindex = sPastindex + j;
+            ringIndices[j*4] = index;  
+            ringIndices[j*4+1] = index + 1 == sIndex + facenumber ? sIndex : (index + 1);
+            ringIndices[j*4+2] = pastindex + 1 == sPastindex + facenumber ? sPastindex : (pastindex + 1);
+            ringIndices[j*4+3] = pastindex;
+
+            // Create uvids
+            ringUVs[j*4] = uvIndex + j;
+            ringUVs[j*4+1] = uvIndex + j + 1;
+            ringUVs[j*4+2] = uvPastindex + j + 1;
+            ringUVs[j*4+3] = uvPastindex + j;
+        }
+
+        ringU[facenumber] = 1.0f - bleed;
+        ringV[facenumber] = vcoordinate;
+    }
+
+    // Cap the end of the branch
+    if(skeleton.ChildCount(branch) == 0 && m_meshdata.capEnds)
+    {
+        // Create middle uvs
+        Float3 middlepos(0.5f, 0.0f, 0.5f);
+        const int middleRing = sectionnumber * uvringnumber;
+        uCoord[middleRing] = middlepos.x;
+        vCoord[middleRing] = middlepos.z;
+        int middleuv = middleRing;
+        int startuv = middleuv + 1;
+        int topindex = (sectionnumber * facenumber) - 1;
+        int midindex = sectionnumber * facenumber;
+        int topj = facenumber-1;
+        Matrix capscale;
+        capscale.Scale(0.25f);
+
+        // Note, this goes backwards
+        int* capPolycounts = &polycounts[(sectionnumber - 1) * facenumber];
+        int* capIndices = &indices[(sectionnumber - 1) * facenumber * 4];
+        int* capUVs = &uvIDs[(sectionnumber - 1) * facenumber * 4];
+        for(int j = 0; j < facenumber; ++j)
+        {
+            // Create faces
+            capPolycounts[j] = 3;
+            int index1 = topindex-j;
+            int index2 = j == topj ? topindex : index1-1;
+            capIndices[j*3] = index2;
+            capIndices[j*3+1] = midindex;
+            capIndices[j*3+2] = index1;
+
+            // Create uvs
+            Float3 position = disk.points[topj - j];
+            position *= capscale;
+            uCoord[middleRing + 1 + j] = position.x + middlepos.x; 
+            vCoord[middleRing + 1 + j] = position.z + middlepos.z;
+            capUVs[j*3] = startuv + j;
+            capUVs[j*3+1] = middleuv;
+            capUVs[j*3+2] = j == topj ? startuv : startuv + j + 1;
+        }
+    }
+}
+
+void TreeBuilder::CreateMesh(const Skeleton& skeleton,
+                             int branch, 
+                             const Disk& disk, 
+                             MeshBuffer& mesh,
+                             const MeshSize& offset)
+{
+    const Float3* positions = &skeleton.positions[skeleton.sectionStarts[branch]];
+    const float* radii = &skeleton.radii[skeleton.sectionStarts[branch]];
+    const MeshBuffer& topology = m_workspace.topologies.Get(m_workspace.branchTopologies[branch]);
+
+    // Copy the shared faces, moving vertex indices past the branches 
+    // before and uv indices to where the uvs of the shape are
+    std::copy(topology.polycounts.begin(), topology.polycounts.end(), &mesh.polycounts[offset.faces]);
+
+    const int vertOffset = static_cast<int>(offset.vertices);
+    const int uvOffset = static_cast<int>(offset.uvs);
+    int* indices = &mesh.indices[offset.indices];
+    int* uvIDs = &mesh.uvIDs[offset.indices];
+    for(unsigned int i = 0; i < topology.indices.size(); ++i)
+    {
+        indices[i] = topology.indices[i] + vertOffset;
+        uvIDs[i] = topology.uvIDs[i] + uvOffset;
+    }
+
+    int facenumber = static_cast<int>(disk.points.size());
+    int sectionnumber = skeleton.sectionCounts[branch];
+    Float3* vertices = &mesh.vertices[offset.vertices];
+
+    // The initial ring continues the last ring of the parent,
+    // parents that were never meshed give no scale
+    const RingFrame* frames = &m_workspace.frames[skeleton.sectionStarts[branch]];
+    float startRadius = 1.0f;
+    const int parent = skeleton.parents[branch];
+    if(parent < 0)
+    { 
+        startRadius = radii[0];
+    }
+    else if(skeleton.sectionCounts[parent] > 1)
+    {
+        startRadius = skeleton.radii[skeleton.sectionStarts[parent] + skeleton.sectionCounts[parent] - 1];
+    }
+
+    // Scale, rotate and translate each ring straight into the mesh
+    TransformPoints(RingTransform(frames[0], positions[0], startRadius), 
+        disk.points.data(), vertices, facenumber);
+
+    for(int i = 1; i < sectionnumber; ++i)
+    {
+        TransformPoints(RingTransform(frames[i], positions[i], radii[i]), 
+            disk.points.data(), &vertices[i * facenumber], facenumber);
+    }
+
+    // Create the middle vertex of the cap
+    if(skeleton.ChildCount(branch) == 0 && m_meshdata.capEnds)
+    {
+        vertices[sectionnumber * facenumber] = positions[sectionnumber-1];
+    }
+}
+
+bool TreeBuilder::IsCancelled()
+{
+    return m_progress.IsCancelled();
+}
@@ -0,0 +1,355 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeBuilder.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeComponents.h"
+#include "treeOutput.h"
+#include "ruleSystem.h"
+#include "profiler.h"
+#include "treeWorkspace.h"
+
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+class RuleReader;
+class RuleStream;
+
+/**
+* Generates a tree from its parameters. Derives the rule, navigates the turtle
+* to build the branches and leaves and creates the geometry of the tree
+*/
+class TreeBuilder
+{
+public:
+
+    /**
+    * Constructor
+    * @param parameters The parameters of the tree
+    * @param progress Receives the progress of generation
+    * @param workspace Memory to reuse for generation or null to allocate it for this tree only
+    */
+    TreeBuilder(const TreeParameters& parameters, 
+                TreeProgress& progress, 
+                TreeWorkspace* workspace = nullptr);
+
+    /**
+    * Destructor
+    */
+    ~TreeBuilder();
+
+    /**
+    * Records the time and work of each stage of generation
+    * @param profiler The profiler to record to or null to stop profiling
+    */
+    void SetProfiler(Profiler* profiler);
+
+    /**
+    * Sets the smallest branch a turtle gives to another worker while building the tree
+    * @param symbols The smallest branch in symbols to split off
+    */
+    void SetSplitSymbols(size_t symbols);
+
+    /**
+    * Derives the rule and builds the branches and leaves of the tree
+    * @return whether the call succeeded
+    */
+    bool BuildSkeleton();
+
+    /**
+    * Creates the curves or meshes of the branches and the leaves of the tree
+    * @param output Receives the geometry
+    * @param treename The name to give the geometry of the tree
+    * @return whether the call succeeded
+    */
+    bool CreateGeometry(TreeOutput& output, const std::string& treename);
+
+    /**
+    * Counts the geometry and nodes CreateGeometry would create without creating them
+    * @note requires the skeleton to be built
+    * @return the counts for the tree
+    */
+    TreeEstimate Estimate() const;
+
+    /**
+    * @return the number of layers of branches in the tree
+    */
+    int LayerCount() const;
+
+    /**
+    * @return the parameters of the tree
+    */
+    const TreeParameters& Parameters() const;
+
+private:
+
+    /**
+    * Prevent copying
+    */
+    TreeBuilder(const TreeBuilder&) = delete;
+    TreeBuilder& operator=(const TreeBuilder&) = delete;
+
+    /**
+    * Builds the production table from the rule arguments
+    */
+    void CompileRules();
+
+    /**
+    * Create the main rule string which determines the three shape
+    * @return Whether generation succeeded
+    */
+    bool CreateRuleString();
+
+    /**
+    * Builds the tree from the generated rule string using a turtle object
+    * @return Whether the call succeeded
+    */
+    bool BuildTheTree();
+
+    /**
+    * Waits for the turtles to finish navigating while updating progress
+    * @param symbolCount The expected number of symbols to navigate
+    * @return Whether the call succeeded
+    */
+    bool WaitForTurtles(size_t symbolCount);
+
+    /**
+    * Navigates the turtle along the symbols of a rule. Run by the workers
+    * @param rule The rule string reader or stream to read symbols from
+    * @param part The part of the tree to fill
+    * @param turtle The turtle to start navigating from
+    */
+    template<typename Rule> void NavigateTurtle(Rule& rule,
+                                               SkeletonPart& part,
+                                               Turtle turtle);
+
+    /**
+    * Gives the branch just opened to another worker if it is large enough
+    * @param rule The rule being read, positioned after the branch's [
+    * @param part The part of the tree being filled
+    * @param turtle The turtle as the branch is opened
+    * @return if the branch was split off
+    */
+    bool TrySplitBranch(RuleReader& rule,
+                        SkeletonPart& part,
+                        const Turtle& turtle);
+
+    /**
+    * Streamed rules are always navigated by a single worker
+    * @return false as the branch is never split off
+    */
+    bool TrySplitBranch(RuleStream& rule,
+                        SkeletonPart& part,
+                        const Turtle& turtle);
+
+    /**
+    * Moves a part of the tree and its splits into the tree in the order of a single turtle
+    * @param part The part of the tree to merge
+    * @param parentIndices The tree index for each branch of the parent part or null for the root
+    */
+    void MergeSkeleton(SkeletonPart& part, const std::vector<int>* parentIndices);
+
+    /**
+    * Links each branch to its children and subtree once all parts are merged
+    * @param tree The branches to link
+    */
+    void BuildHierarchy(Skeleton& tree) const;
+
+    /**
+    * Checks whether branch is alive or dead and removes any
+    * successive rules after the branch if it is dead
+    * @param rule The rule being read, positioned after the branch's [
+    * @param random The random stream of the current branch
+    * @return if the branch is dead or not
+    */
+    template<typename Rule> bool TryKillBranch(Rule& rule, RandomStream& random);
+
+    /**
+    * Creates the random stream for the next child of the turtle's branch
+    * @param part The part of the tree holding the turtle's branch
+    * @param turtle The turtle navigating the rule string
+    * @return the random stream for the child branch
+    */
+    RandomStream NextRandomStream(SkeletonPart& part, const Turtle& turtle) const;
+
+    /**
+    * Creates a new branch and changes branch values as necessary
+    * @param turtle The tutle navigating the rule string
+    * @param part The part of the tree to add the branch to
+    * @param random The random stream for the new branch
+    * @param values The current data used for generating branches
+    */
+    void BuildNewBranch(Turtle& turtle,
+                        SkeletonPart& part,
+                        const RandomStream& random,
+                        const BranchData** values);
+
+    /**
+    * Determines the forward position of the turtle
+    * @param turtle The turtle object
+    * @param random The random stream of the current branch
+    * @param forward How far forward to move
+    * @param angle How much should the turtle rotate from the initial position
+    * @param variation How much variation of the distance/rotation values
+    * @return The position generated
+    */
+    Float3 DetermineForwardMovement(const Turtle& turtle,
+                                    RandomStream& random,
+                                    double forward,
+                                    double angle,
+                                    double variation) const;
+
+    /**
+    * @param layer The layer of the branch
+    * @param level The level of detail, zero being the full tree
+    * @return the number of faces around a branch on the layer
+    */
+    int DiskFaces(int layer, int level) const;
+
+    /**
+    * @return the number of levels of detail the branches are meshed at
+    */
+    int LevelCount() const;
+
+    /**
+    * Reduces the tree for a level of detail by removing thin branches with all their
+    * children and removing the sections along the straight runs of each branch
+    * @param level The level of detail, above zero
+    * @param lod Filled with the branches kept by the level of detail
+    * @param branches Filled with the index in the tree of each branch kept
+    */
+    void CreateLevelOfDetail(int level, Skeleton& lod, std::vector<int>& branches) const;
+
+    /**
+    * Create all the meshes of the tree for each level of detail
+    * @param output Receives the meshes
+    * @param whether or not creation was successful
+    */
+    bool CreateMeshes(TreeOutput& output);
+
+    /**
+    * Create the meshes of the branches for a level of detail
+    * @param skeleton The branches to mesh
+    * @param branches The index in the tree of each branch or null if the branches are the tree
+    * @param level The level of detail, zero being the full tree
+    * @param progress Branches meshed since the progress bar last advanced
+    * @param output Receives the meshes
+    * @param whether or not creation was successful
+    */
+    bool CreateBranchMeshes(const Skeleton& skeleton,
+                            const std::vector<int>* branches,
+                            int level,
+                            size_t& progress,
+                            TreeOutput& output);
+
+    /**
+    * Orients the ring around each section by carrying the frame of the 
+    * previous ring along the branch, starting from the parent's last ring
+    * @param skeleton The branches to orient the rings of
+    */
+    void CreateRingFrames(const Skeleton& skeleton);
+
+    /**
+    * @param skeleton The branches being meshed
+    * @param branch The index of the branch
+    * @param level The level of detail, zero being the full tree
+    * @return the number of elements the branch adds to each buffer of a mesh
+    */
+    MeshSize BranchMeshSize(const Skeleton& skeleton, int branch, int level) const;
+
+    /**
+    * Creates the faces and uvs of a branch with vertex and uv indices starting from zero
+    * @param skeleton The branches being meshed
+    * @param branch The index of the branch
+    * @param level The level of detail, zero being the full tree
+    * @param disk The vertex disc information for the dimensions of the mesh
+    * @param topology Filled with the faces and uvs
+    */
+    void CreateTopology(const Skeleton& skeleton,
+                        int branch,
+                        int level,
+                        const Disk& disk,
+                        MeshBuffer& topology) const;
+
+    /**
+    * Writes the vertices and faces of an individual branch into a mesh already sized for it
+    * @param skeleton The branches being meshed
+    * @param branch The index of the branch
+    * @param disk The vertex disc information for the dimensions of the mesh
+    * @param mesh The mesh to write the branch to, already holding the uvs of its shape
+    * @param offset Where the branch starts in each buffer and where the uvs of its shape are
+    */
+    void CreateMesh(const Skeleton& skeleton,
+                    int branch,
+                    const Disk& disk,
+                    MeshBuffer& mesh,
+                    const MeshSize& offset);
+
+    /**
+    * Create all the leaves of tree
+    * @param output Receives the leaves
+    * @param whether or not creation was successful
+    */
+    bool CreateLeaves(TreeOutput& output);
+
+    /**
+    * Creates all leaves as instances of a few leaf prototypes
+    * @param randoms The random values between -1/1 for all leaves
+    * @param output Receives the leaf instancer
+    * @return whether or not creation was successful
+    */
+    bool CreateLeafInstances(const std::vector<float>& randoms, TreeOutput& output);
+
+    /**
+    * Generates the world space vertices of an individual leaf
+    * @param leaf The leaf object to create
+    * @param random The random values between -1/1 for the leaf
+    * @param vertices Filled with the vertices of the leaf
+    */
+    void CreateLeafVertices(Leaf& leaf, const float* random, Float3* vertices);
+
+    /**
+    * Writes the faces of a leaf into a mesh already sized for it using the shared leaf topology
+    * @param offset Where the leaf starts in each buffer of the mesh
+    * @param mesh The mesh to write the leaf to
+    */
+    void WriteLeaf(const MeshSize& offset, MeshBuffer& mesh);
+
+    /**
+    * Create all the curves of the tree
+    * @param output Receives the curves
+    * @return Whether or not creation was successful
+    */
+    bool CreateCurves(TreeOutput& output);
+
+    /**
+    * @return whether or not generation was cancelled mid operation
+    */
+    bool IsCancelled();
+
+    TreeProgress& m_progress;                   ///< Receives the progress of generation
+    Profiler* m_profiler = nullptr;             ///< Records each stage of generation if profiling
+    unsigned int m_progressIncrease = 0;        ///< How much each step can increase the progress bar overall by
+    unsigned int m_progressStep = 0;            ///< Minimum amount at one time the progress bar can increase by
+    std::unique_ptr<TreeWorkspace> m_ownWorkspace; ///< Memory for generation if no workspace was given
+    TreeWorkspace& m_workspace;                 ///< Memory reused for generation
+    ThreadPool& m_threads;                      ///< Workers for splitting up generation
+    TreeParameters m_parameters;                ///< The parameters of the tree
+    MeshData& m_meshdata;                       ///< Holds data for a mesh of a branch
+    LeafData& m_leafdata;                       ///< Holds data for a mesh of a leaf
+    TreeData& m_treedata;                       ///< Holds rule data for the overall tree
+    ShadingData& m_fxdata;                      ///< Holds Shading data for the tree/leaves
+    Skeleton& m_skeleton;                       ///< All branches of the tree including the trunk
+    std::vector<Leaf>& m_leaves;                ///< All leaves of the tree
+    MeshBuffer& m_leafTopology;                 ///< Faces and uvs shared by all leaves
+    std::string& m_rule;                        ///< The derived rule string
+    RuleSystem m_rules;                         ///< Compiled production table for the rules
+    std::atomic<size_t> m_symbolsRead;          ///< Symbols read so far by all turtles
+    size_t m_symbolCount = 0;                   ///< Symbols in the final rule
+    size_t m_splitSymbols = 0;                  ///< Smallest branch given to another worker
+    std::atomic<bool> m_turtlesCancelled;       ///< Whether the turtles should stop navigating
+};
@@ -4,12 +4,15 @@
 
 #pragma once
 
-#include "common.h"
 #include "vector3.h"
 #include "matrix.h"
+#include "quaternion.h"
+#include "randomGenerator.h"
 
 #include <string>
-#include <deque>
+#include <vector>
+#include <array>
+#include <ostream>
 
 /**
 * Holds Shading data for the tree/leaves
@@ -64,10 +67,13 @@ struct TreeData
     double branchRadiusDecrease;       ///< The amount to decrease the radius
     double minimumRadius;              ///< The minimum allowed radius
     unsigned branchDeathProbability;   ///< The probability from 0-100% of the branch dying
-    std::string rule;                  ///< The rule string the tree abides by
-    MString treename;                  ///< The name of the tree
-    MString treeshadername;            ///< The name of the tree's shader
-    MObject tree;                      ///< Tree Maya object
+    bool streamRule;                   ///< Whether to derive the rule as the turtle reads it
+    bool pruneBranches;                ///< Whether branches die during derivation rather than building
+    unsigned int seed;                 ///< Seed all random values of the tree are generated from
+    std::string prerule;               ///< Symbols placed before the derived rule
+    std::string axiom;                 ///< Symbols the rule is derived from
+    std::string postrule;              ///< Symbols placed after the derived rule
+    std::string treename;              ///< The name of the tree
 
     /**
     * Constructor
@@ -80,7 +86,10 @@ struct TreeData
         initialRadius(radius),
         branchRadiusDecrease(radiusDecrease),
         minimumRadius(minRadius),
-        branchDeathProbability(deathProbability)
+        branchDeathProbability(deathProbability),
+        streamRule(false),
+        pruneBranches(false),
+        seed(0)
     {
     }
 };
@@ -118,12 +127,23 @@ struct BranchData
     }
 };
 
+/**
+* How branches are grouped into mesh nodes
+*/
+enum MeshMode
+{
+    MESH_PER_BRANCH,    ///< A mesh node for each branch
+    MESH_PER_LAYER,     ///< A mesh node for all branches of a layer
+    MESH_PER_TREE       ///< A single mesh node for all branches
+};
+
 /**
 * Holds data for a mesh of a branch
 */
 struct MeshData
 {
     int maxLayers;                      ///< Number of mesh layers for the branch
+    unsigned int meshMode;              ///< How branches are grouped into mesh nodes
     bool preview;                       ///< Whether or not this is a preview tree   
     bool capEnds;                       ///< Whether to Fill in tips of tree with polygons
     bool createAsCurves;                ///< Whether the tree is created via curves or mesh
@@ -131,6 +151,7 @@ struct MeshData
     unsigned int trunkfaces;            ///< Number of faces around the trunk
     unsigned int branchfaces;           ///< Number of faces around branches
     unsigned int faceDecrease;          ///< Number of faces to reduce per branch layer
+    unsigned int lods;                  ///< Number of branch meshes of decreasing detail to create
 
     /**
     * Constructor
@@ -145,23 +166,35 @@ struct MeshData
     MeshData(unsigned numTrunkFaces, unsigned numBranchFaces, unsigned numFaceDecrease,
         bool useCurves, bool capBranchEnds, bool randomizeTree, bool previewTree) :
             maxLayers(0),
+            meshMode(MESH_PER_BRANCH),
             preview(previewTree),
             capEnds(capBranchEnds),
             createAsCurves(useCurves),
             randomize(randomizeTree),
             trunkfaces(numTrunkFaces),
             branchfaces(numBranchFaces),
-            faceDecrease(numFaceDecrease)
+            faceDecrease(numFaceDecrease),
+            lods(1)
     {
     }
 };
 
+/**
+* How leaves are grouped into mesh nodes
+*/
+enum LeafMode
+{
+    LEAF_PER_LEAF,      ///< A mesh node for each leaf
+    LEAF_PER_LAYER,     ///< A mesh node for all leaves of a layer
+    LEAF_INSTANCED      ///< Instances of a few leaf prototypes through an instancer node
+};
+
 /**
 * Holds data for a mesh of a leaf
 */
 struct LeafData
 {
-    MString leafshadername;     ///< Name of the shader
+    unsigned leafMode;          ///< How leaves are grouped into mesh nodes
     unsigned leafLayer;         ///< Current layer that is being leafed
     bool treeHasLeaves;         ///< Whether or not the tree has leaves
     double width;               ///< Width of the leaf mesh
@@ -169,7 +202,7 @@ struct LeafData
     double widthVariance;       ///< Amount to vary the width of the leaf
     double heightVariance;      ///< Amount to vary the height of the leaf
     double bendAmount;          ///< Amount to bend the leaf
-    MString file;               ///< Filename for the leaf texture
+    std::string file;           ///< Filename for the leaf texture
 
     /**
     * Constructor
@@ -183,6 +216,7 @@ struct LeafData
     */
     LeafData(bool leafTree, double leafWidth, double leafHeight, double leafWidthVariance, 
         double leafHeightVariance, double bend, unsigned layerNumber) :
+            leafMode(LEAF_PER_LEAF),
             leafLayer(layerNumber),
             treeHasLeaves(leafTree),
             width(leafWidth),
@@ -195,68 +229,135 @@ struct LeafData
 };
 
 /**
-* Holds data for a section of a branch
+* All branches of the tree stored as flat arrays indexed by branch.
+* The sections of each branch are contiguous in the section arrays.
+* Branches are in depth first order so every parent comes before its
+* children and each subtree is a contiguous range of branches
 */
-struct Section
+struct Skeleton
 {
-    Float3 position;    ///< Position of the section
-    float radius;       ///< Radius of the section
+    std::vector<Float3> positions;      ///< Position of every section
+    std::vector<float> radii;           ///< Radius of every section
+    std::vector<int> sectionStarts;     ///< Index of the first section of each branch
+    std::vector<int> sectionCounts;     ///< Number of sections of each branch
+    std::vector<int> parents;           ///< Index of the parent of each branch or -1 for the trunk
+    std::vector<int> layers;            ///< Layer each branch exists on
+    std::vector<int> childStarts;       ///< Index of the first child of each branch, ending with the child total
+    std::vector<int> children;          ///< Children of every branch grouped by parent
+    std::vector<int> subtreeEnds;       ///< Index after the last branch of each branch's subtree
 
     /**
-    * Constructor
+    * @return the number of branches including the trunk
     */
-    Section() :
-        radius(0.0f)
+    size_t BranchCount() const
     {
+        return parents.size();
     }
 
     /**
-    * Constructor
-    * @param pos The position of the section
-    * @param rad The radius of the section
+    * @param branch The index of the branch
+    * @return the number of children extending from the branch
     */
-    Section(const Float3& pos, float rad) :
-        position(pos),
-        radius(rad)
-    { 
+    int ChildCount(int branch) const
+    {
+        return childStarts[branch + 1] - childStarts[branch];
     }
 
     /**
-    * Constructor
-    * @param x/y/z The position of the section
-    * @param rad The radius of the section
+    * @return the number of sections of all branches
     */
-    Section(float x, float y, float z, float rad) :
-        position(x, y, z),
-        radius(rad)
-    { 
+    size_t SectionCount() const
+    {
+        return positions.size();
+    }
+
+    /**
+    * Removes all branches
+    */
+    void Clear()
+    {
+        positions.clear();
+        radii.clear();
+        sectionStarts.clear();
+        sectionCounts.clear();
+        parents.clear();
+        layers.clear();
+        childStarts.clear();
+        children.clear();
+        subtreeEnds.clear();
     }
 };
 
 /**
-* Holds data for a branch
+* Orientation of the ring of vertices around a section
 */
-struct Branch
+struct RingFrame
 {
-    Matrix rotationMat;       ///< Branch rotation matrix
-    Matrix scaleMat;          ///< Branch scale matrix
-    int parentIndex;          ///< Index of the parent to this branch
-    int sectionIndex;         ///< Index of the branch
-    int layer;                ///< Layer that the branch exists on
-    int vertNumber;           ///< Number of vertices of this branch
-    MObject mesh;             ///< The maya mesh for the branch
-    std::deque<Section> sections;  ///< The number of sections for this branch
-    std::deque<int> children;      ///< A container of children extending from this branch
+    Float3 tangent;     ///< Direction the ring faces
+    Float3 normal;      ///< Direction of the first vertex of the ring
+};
+
+/**
+* Number of elements in each buffer of a mesh
+*/
+struct MeshSize
+{
+    size_t vertices = 0;    ///< Number of vertex positions
+    size_t faces = 0;       ///< Number of faces
+    size_t indices = 0;     ///< Number of vertex and uv indices of all faces
+    size_t uvs = 0;         ///< Number of UVs
 
     /**
-    * Constructor
+    * Adds the elements of another mesh
     */
-    Branch() :
-        parentIndex(-1),
-        sectionIndex(-1),
-        layer(0),
-        vertNumber(0)
-    { 
+    MeshSize& operator+=(const MeshSize& size)
+    {
+        vertices += size.vertices;
+        faces += size.faces;
+        indices += size.indices;
+        uvs += size.uvs;
+        return *this;
+    }
+};
+
+/**
+* Geometry buffers for building a single mesh node
+*/
+struct MeshBuffer
+{
+    std::vector<Float3> vertices;   ///< Vertex positions
+    std::vector<int> polycounts;    ///< Number of vertices for each face
+    std::vector<int> indices;       ///< Vertex indices for each face
+    std::vector<int> uvIDs;         ///< UV indices for each face
+    std::vector<float> uCoord;      ///< U value for each UV
+    std::vector<float> vCoord;      ///< V value for each UV
+
+    /**
+    * Removes all geometry
+    */
+    void Clear()
+    {
+        vertices.clear();
+        polycounts.clear();
+        indices.clear();
+        uvIDs.clear();
+        uCoord.clear();
+        vCoord.clear();
+    }
+
+    /**
+    * Sizes all buffers to be filled by index, only 
+    * allocating when larger than any size before
+    * @param size The number of elements of each buffer
+    */
+    void Resize(const MeshSize& size)
+    {
+        vertices.resize(size.vertices);
+        polycounts.resize(size.faces);
+        indices.resize(size.indices);
+        uvIDs.resize(size.indices);
+        uCoord.resize(size.uvs);
+        vCoord.resize(size.uvs);
     }
 };
 
@@ -265,7 +366,7 @@ struct Branch
 */
 struct Disk
 {
-    std::deque<Float3> points; ///< vertices of a branch disk
+    std::vector<Float3> points; ///< vertices of a branch disk
 };
 
 /**
@@ -274,7 +375,6 @@ struct Disk
 struct Leaf
 {
     int layer;              ///< Layer the leaf exists on
-    MObject mesh;           ///< Mesh for the leaf
     Float3 position;        ///< Position of the leaf mesh
     Float3 sectionAxis;     ///< Axis for the branch section that leaf lives on
     float sectionRadius;    ///< Radius for the branch section that leaf lives on
@@ -300,7 +400,10 @@ struct Leaf
 */
 struct Turtle
 {
-    Matrix world;       ///< Turtle world matrix
+    Float3 position;            ///< Turtle world position
+    Float3 sectionPosition;     ///< Position of the last section of the branch generating
+    Float3 sectionAxis;         ///< Direction from the previous section to the last section
+    Quaternion orientation;     ///< Turtle world orientation
     double radius;      ///< Current radius of the tree section generating
     int branchIndex;    ///< Current index of the branch generating
     int sectionIndex;   ///< Current index of the branch section generation
@@ -323,11 +426,133 @@ struct Turtle
 };
 
 /**
-* A layer of the tree 
+* Branches and leaves built by a single turtle task. Branch parent indices are local
+* to the part except for the first branch of a split part, which indexes its parent part.
+* Sections are kept in the order they are created and grouped by branch when merged
 */
-struct Layer
+struct SkeletonPart
 {
-    MObject layer;      ///< Layer Maya object
-    MObject branches;   ///< Branches Maya object
-    MObject leaves;     ///< Leaves Maya object
+    /**
+    * A part split off to be built by another task
+    */
+    struct Split
+    {
+        size_t branchCount;                 ///< Number of branches in the parent part before the split
+        size_t leafCount;                   ///< Number of leaves in the parent part before the split
+        SkeletonPart* part;                 ///< The part built for the split branch
+    };
+
+    std::vector<Float3> positions;          ///< Position of each section created by the task
+    std::vector<float> radii;               ///< Radius of each section created by the task
+    std::vector<int> sectionBranches;       ///< Branch each section belongs to
+    std::vector<int> sectionCounts;         ///< Number of sections of each branch
+    std::vector<int> parents;               ///< Index of the parent of each branch
+    std::vector<int> layers;                ///< Layer each branch exists on
+    std::vector<Leaf> leaves;               ///< All leaves created by the task
+    std::vector<RandomStream> randoms;      ///< Random stream for each branch
+    std::vector<unsigned int> childCounts;  ///< Number of children created for each branch
+    std::vector<Split> splits;              ///< Parts split off in the order they occur
+    int maxLayers = 0;                      ///< Deepest layer reached by the task
+
+    /**
+    * Removes all branches, leaves and splits
+    */
+    void Clear()
+    {
+        positions.clear();
+        radii.clear();
+        sectionBranches.clear();
+        sectionCounts.clear();
+        parents.clear();
+        layers.clear();
+        leaves.clear();
+        randoms.clear();
+        childCounts.clear();
+        splits.clear();
+        maxLayers = 0;
+    }
+};
+
+/**
+* All parameters for generating a tree
+*/
+struct TreeParameters
+{
+    static const int RULE_NUMBER = 10;                    ///< Maximum amount of rules allowed
+
+    unsigned int iterations;                              ///< The number of iterations of the rules to do
+    BranchData trunk;                                     ///< Rule data for the trunk
+    BranchData branch;                                    ///< Rule data for the branches
+    MeshData mesh;                                        ///< Holds data for a mesh of a branch
+    LeafData leaf;                                        ///< Holds data for a mesh of a leaf
+    TreeData tree;                                        ///< Holds rule data for the overall tree
+    ShadingData shading;                                  ///< Holds Shading data for the tree/leaves
+    std::array<std::string, RULE_NUMBER> ruleIDs;         ///< The rule characters
+    std::array<std::string, RULE_NUMBER> ruleStrings;     ///< The rules to replace the rule characters
+    std::array<unsigned int, RULE_NUMBER> ruleChances;    ///< The probability for each rule character
+
+    /**
+    * Constructor, sets up the default tree
+    */
+    TreeParameters() :
+        iterations(4),
+        trunk(1.0, 5.0, 0.2, 22.2, 5.0, 0.9),
+        branch(1.0, 15.0, 0.5, 22.2, 5.0, 0.95),
+        mesh(8, 8, 2, false, false, true, false),
+        leaf(true, 2.0f, 4.0f, 1.0f, 1.0f, 1.0f, 2),
+        tree(2.0, 0.9, 0.001, 10),
+        shading(0.732982, 0.495995, 0.388067, 0.083772, 
+                0.0572824, 0.013138, true, true, true, 0.2, 0.01)
+    {
+        tree.prerule = "FGGFGGFGGF";
+        tree.axiom = "A";
+        ruleIDs[0] = "A";
+        ruleStrings[0] = "[>FGLLLFGLLLFLLLA]^^^^^[>FGLLLFGLLLFLLLA]^^^^^^^[>FGLLLFGLLLFLLLA]";
+        ruleChances.fill(0);
+        ruleChances[0] = 100;
+    }
+};
+
+/**
+* Counts of the geometry and nodes generating a tree will create
+*/
+struct TreeEstimate
+{
+    size_t symbols = 0;         ///< Symbols in the final rule
+    size_t branches = 0;        ///< Branches including the trunk
+    size_t sections = 0;        ///< Sections of all branches
+    size_t leaves = 0;          ///< Leaves of the tree
+    size_t branchVertices = 0;  ///< Vertices of the branch meshes or curves
+    size_t branchFaces = 0;     ///< Faces of the branch meshes
+    size_t leafVertices = 0;    ///< Vertices of the leaf meshes or prototypes
+    size_t leafFaces = 0;       ///< Faces of the leaf meshes or prototypes
+    size_t instances = 0;       ///< Leaves placed by the instancer
+    size_t meshNodes = 0;       ///< Mesh nodes for branches, leaves and leaf prototypes
+    size_t curveNodes = 0;      ///< Curve nodes for branches
+    size_t instancerNodes = 0;  ///< Instancer nodes for leaves
+    size_t groupNodes = 0;      ///< Transform nodes grouping the tree and its layers
+
+    /**
+    * Writes the counts as JSON
+    * @param stream The stream to write to
+    */
+    void WriteReport(std::ostream& stream) const
+    {
+        stream << "{\"symbols\": " << symbols
+               << ", \"branches\": " << branches
+               << ", \"sections\": " << sections
+               << ", \"leaves\": " << leaves
+               << ", \"vertices\": " << branchVertices + leafVertices
+               << ", \"faces\": " << branchFaces + leafFaces
+               << ", \"branchVertices\": " << branchVertices
+               << ", \"branchFaces\": " << branchFaces
+               << ", \"leafVertices\": " << leafVertices
+               << ", \"leafFaces\": " << leafFaces
+               << ", \"instances\": " << instances
+               << ", \"nodes\": " << meshNodes + curveNodes + instancerNodes + groupNodes
+               << ", \"meshNodes\": " << meshNodes
+               << ", \"curveNodes\": " << curveNodes
+               << ", \"instancerNodes\": " << instancerNodes
+               << ", \"groupNodes\": " << groupNodes << "}";
+    }
 };
@@ -6,23 +6,50 @@
 
 #include "common.h"
 #include "treeComponents.h"
+#include "treeOutput.h"
+#include "shaderCache.h"
+#include "treeWorkspace.h"
+#include "mayaMesh.h"
 
+#include <deque>
 #include <memory>
-#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+class TreeBuilder;
+class Profiler;
+class LeafInstanceNode;
+
+/**
+* A layer of the tree
+*/
+struct Layer
+{
+    MObject layer;      ///< Layer Maya object
+    MObject branches;   ///< Branches Maya object
+    MObject leaves;     ///< Leaves Maya object
+};
 
 /**
-* Core command class for generating the trees. The GUI
-* window will pass in arguments to customise this process
+* Core command class for generating the trees. The GUI window will pass in
+* arguments to customise this process. Generation is done by the TreeBuilder
+* with this class creating the Maya nodes for the geometry it outputs
 */
-class TreeGenerator : public MPxCommand
+class TreeGenerator : public MPxCommand, public TreeOutput, public TreeProgress
 {
-public: 
+public:
 
     /**
     * Constructor
     */
     TreeGenerator();
 
+    /**
+    * Destructor
+    */
+    ~TreeGenerator();
+
     /**
     * @return whether or not this plugin is able to be undone/redone
     */
@@ -46,121 +73,113 @@ public:
     */
     static MSyntax newSyntax();
 
-private:
-
     /**
-    * Delete all currently constructed nodes 
+    * Frees the memory kept between trees for generating the next tree
     */
-    void DeleteNodes();
+    static void ReleaseWorkspace();
 
     /**
-    * Begin creating a mesh around the generated tree
-    * @return whether the call succeeded
+    * Creates a mesh node under the tree
+    * @param mesh The geometry of the mesh
+    * @param name The name of the mesh
+    * @param layer The layer the mesh exists in or -1 for the whole tree
+    * @param leaves Whether the mesh holds leaves rather than branches
+    * @param branchFaces Triples of branch index, first face and face count if branches are merged
     */
-    bool MeshTheTree();
+    virtual void AddMesh(const MeshBuffer& mesh,
+                         const std::string& name,
+                         int layer,
+                         bool leaves,
+                         const std::vector<int>& branchFaces) override;
 
     /**
-    * Create the main rule string which determines the three shape
-    * @return Whether generation succeeded
+    * Creates a curve node under the tree
+    * @param points The edit points of the curve
+    * @param name The name of the curve
+    * @param layer The layer the curve exists in
     */
-    bool CreateRuleString();
+    virtual void AddCurve(const std::vector<Float3>& points,
+                          const std::string& name,
+                          int layer) override;
 
     /**
-    * Builds the tree from the generated rule string using a turtle object
-    * @param branch Data for the tree trunk
-    * @param trunk Data for the tree branches
-    * @return Whether the call succeeded
+    * Creates an instancer node under the tree
+    * @param topology The faces and uvs shared by all leaf prototypes
+    * @param name The name of the instancer
+    * @return the sink to receive the prototypes and instances
     */
-    bool BuildTheTree(BranchData& branch, BranchData& trunk);
+    virtual LeafInstanceSink& AddLeafInstancer(const MeshBuffer& topology,
+                                               const std::string& name) override;
 
     /**
-    * Checks whether branch is alive or dead and removes any 
-    * successive rules after the branch if it is dead
-    * @param index The index in the rule string of the current branch
-    * @return if the branch is dead or not
+    * Sets the descriptive text of the progress window
+    * @param description The text to display in the progress window
     */
-    bool TryKillBranch(unsigned int& index);
+    virtual void Describe(const char* description) override;
 
     /**
-    * Creates a new branch and changes branch values as necessary
-    * @param turtle The tutle navigating the rule string
-    * @param trunkIndex The index for the trunk of the tree
-    * @param trunk The data used for generating trunks
-    * @param values The current data used for generating branches
+    * Advance the progress window by an amount
+    * @param amount The amount of steps to increase progress by
     */
-    void BuildNewBranch(Turtle& turtle, 
-                        int trunkIndex, 
-                        BranchData& trunk,
-                        BranchData** values);
+    virtual void Advance(int amount) override;
 
     /**
-    * Determines the forward position of the turtle
-    * @param turtle The turtle object
-    * @param forward How far forward to move
-    * @param angle How much should the turtle rotate from the initial position
-    * @param variation How much variation of the distance/rotation values
-    * @return The position generated
+    * @return whether or not the plugin was cancelled mid operation
     */
-    Float3 DetermineForwardMovement(const Turtle& turtle,
-                                    double forward, 
-                                    double angle, 
-                                    double variation) const;
-    
+    virtual bool IsCancelled() override;
+
+private:
+
     /**
-    * Create all the meshes of the tree
-    * @param whether or not creation was successful
+    * Delete all currently constructed nodes
     */
-    bool CreateMeshes();
+    void DeleteNodes();
 
     /**
-    * Create an individual branch mesh
-    * @param branch The branch object
-    * @param parent The branch's parent
-    * @param disk The vertex disc information for the dimensions of the mesh
-    * @param meshname The name of the mesh generated
-    * @param layer The layer the mesh exists in
+    * Begin creating a mesh around the generated tree
+    * @return whether the call succeeded
     */
-    void CreateMesh(Branch* branch, 
-                    Branch* parent, 
-                    Disk& disk, 
-                    MString& meshname, 
-                    MObject& layer);
+    bool MeshTheTree();
 
     /**
-    * Create all the leaves of tree
-    * @param whether or not creation was successful
+    * Creates a mesh node from geometry
+    * @param mesh The geometry of the mesh
+    * @param meshname The name of the mesh generated
+    * @param layer The layer the mesh exists in
+    * @param shader The shading group to assign
+    * @return the mesh created
     */
-    bool CreateLeaves();
+    MObject CreateMeshNode(const MeshBuffer& mesh,
+                           const MString& meshname,
+                           MObject& layer,
+                           const MString& shader);
 
     /**
-    * Create an individual leaf
-    * @param leaf The leaf object to create
-    * @param meshname The name of the leaf mesh
-    * @param layer What layer the mesh lives in
+    * Queues a node to be added to a shading group once all nodes are created
+    * @param shader The name of the shading group
+    * @param node The node to shade
     */
-    void CreateLeaf(Leaf& leaf, MString& meshname, MObject& layer);
+    void AddToShadingGroup(const MString& shader, const MObject& node);
 
     /**
-    * Create all the curves of the tree
-    * @return Whether or not creation was successful
+    * Adds all queued nodes to their shading groups in a single call for each group
     */
-    bool CreateCurves();
+    void AssignShadingGroups();
 
     /**
-    * Create an individual curve for the curve tree
-    * @param branch The branch object
-    * @param meshname The name of the curve created
-    * @param layer The layer the curve exists in
+    * Records which faces belong to which branch on a merged mesh
+    * @param node The merged mesh
+    * @param branchFaces Triples of branch index, first face and face count
     */
-    void CreateCurve(Branch& branch, MString& meshname, MObject& layer);
+    void AddBranchFaces(MObject& node, const std::vector<int>& branchFaces);
 
     /**
-    * Create all the groups for the layers of the tree 
+    * Create all the groups for the layers of the tree
     */
     bool CreateTreeGroup();
 
     /**
-    * Create all the shaders for the tree
+    * Gets the shaders for the tree, sharing any created for earlier trees with the same settings
     */
     bool CreateShaders();
 
@@ -176,67 +195,40 @@ private:
     void TurnOffHistory();
 
     /**
-    * Begin a progress window
-    * @param stepNumber The amount of overall steps for the plugin
-    */
-    void StartProgressWindow(int stepNumber);
-
-    /**
-    * Sets the descriptive text of the progress window
-    * @param description The text to display in the progress window
+    * Returns the profile of generating the tree as the result of the command
+    * @param traceFile The file to write a Chrome trace to or empty if not required
     */
-    void DescribeProgressWindow(const char* description);
+    void ReportProfile(const MString& traceFile);
 
     /**
-    * Advance the progress window by an amount
-    * @param amount The amount of steps to increase progress by
+    * Returns the counts of the geometry and nodes the tree would create as the result of the command
     */
-    void AdvanceProgressWindow(int amount);
+    void ReportEstimate();
 
     /**
-    * @return whether or not the plugin was cancelled mid operation
+    * Begin a progress window
     */
-    bool PluginIsCancelled();
+    void StartProgressWindow();
 
     /**
     * Closes the progress window
     */
     void EndProgressWindow();
 
-    /**
-    * Get all flag arguments passed from the gui
-    * @param argData the arguement data
-    * @param prerule/postrule/start The rules governing the tree appearance
-    * @param branch/trunk The branch and tree data to fill in
-    */
-    void GetFlagArguments(const MArgDatabase& argData, 
-                          MString prerule,
-                          MString postrule, 
-                          MString start, 
-                          BranchData& branch, 
-                          BranchData& trunk);
-
     static int sm_treeNumber;                   ///< Number of trees generated in the current Maya session
-    unsigned int m_progressIncrease = 0;        ///< How much each step can increase the progress bar overall by
-    unsigned int m_progressStep = 0;            ///< Minimum amount at one time the progress bar can increase by
-    unsigned int m_iterations = 4;              ///< The number of iterations of the rules to do
+    static ShaderCache sm_shaderCache;          ///< Shader networks shared by all trees in the current Maya session
+    static TreeWorkspace sm_workspace;          ///< Memory reused by every tree in the current Maya session
+    static MayaMeshArrays sm_meshArrays;        ///< Arrays reused to pass every mesh to Maya
     std::unique_ptr<MDagModifier> m_dagMod;     ///< Maya DAG node modifier object
-    MeshData m_meshdata;                        ///< Holds data for a mesh of a branch
-    LeafData m_leafdata;                        ///< Holds data for a mesh of a leaf
-    TreeData m_treedata;                        ///< Holds rule data for the overall tree
-    ShadingData m_fxdata;                       ///< Holds Shading data for the tree/leaves
+    std::unique_ptr<TreeBuilder> m_builder;     ///< Generates the tree
+    std::unique_ptr<LeafInstanceNode> m_leafInstances; ///< Instancer for the leaves if used
+    std::unique_ptr<Profiler> m_profiler;       ///< Records each stage of generation if profiling
+    TreeParameters m_parameters;                ///< All parameters for generating the tree
+    bool m_showProgress = true;                 ///< Whether the progress window is shown
+    MString m_treename;                         ///< The name of the tree
+    MString m_treeShader;                       ///< The name of the tree's shading group
+    MString m_leafShader;                       ///< The name of the leaves' shading group
+    MObject m_tree;                             ///< Tree Maya object
     std::deque<Layer> m_layers;                 ///< All layers of the tree
-    std::deque<Branch> m_branches;              ///< All branches of the tree including the trunk
-    std::deque<Leaf> m_leaves;                  ///< All leaves of the tree
-    std::deque<Float3> m_leafVertices;          ///< Container of vertices for a leaf
-    MIntArray m_leafPolycounts;                 ///< Poly count for a leaf
-    MIntArray m_leafIndices;                    ///< Indices for a leaf
-    MFloatArray m_leafU;                        ///< U value for UVs for a leaf
-    MFloatArray m_leafV;                        ///< V value for UVs for a leaf
-    MIntArray m_leafUVids;                      ///< UV IDS for UVs for a leaf
-
-    static const int RULE_NUMBER = 10;                    ///< Maximum amount of rules allowed
-    std::array<MString, RULE_NUMBER> m_ruleIDs;           ///< The rule characters
-    std::array<MString, RULE_NUMBER> m_ruleStrings;       ///< The rules to replace the rule characters
-    std::array<unsigned int, RULE_NUMBER> m_ruleChances;  ///< The probability for each rule character
-};                                           
\ No newline at end of file
+    std::map<std::string, std::vector<MObject>> m_shadingMembers; ///< Nodes waiting to be added to each shading group
+};
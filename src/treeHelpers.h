@@ -4,6 +4,9 @@
 
 #pragma once
 
+#define _USE_MATH_DEFINES
+#include <math.h>
+
 /**
 * Converts degrees to radians
 */
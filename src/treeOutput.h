@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeOutput.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeComponents.h"
+#include "leafInstancer.h"
+
+#include <string>
+#include <vector>
+
+/**
+* Receives the geometry of a tree as it is created
+*/
+class TreeOutput
+{
+public:
+
+    /**
+    * Destructor
+    */
+    virtual ~TreeOutput() = default;
+
+    /**
+    * Adds a mesh to the tree
+    * @param mesh The geometry of the mesh
+    * @param name The name of the mesh
+    * @param layer The layer the mesh exists in or -1 for the whole tree
+    * @param leaves Whether the mesh holds leaves rather than branches
+    * @param branchFaces Triples of branch index, first face and face count if branches are merged
+    */
+    virtual void AddMesh(const MeshBuffer& mesh,
+                         const std::string& name,
+                         int layer,
+                         bool leaves,
+                         const std::vector<int>& branchFaces) = 0;
+
+    /**
+    * Adds a curve to the tree
+    * @param points The edit points of the curve
+    * @param name The name of the curve
+    * @param layer The layer the curve exists in
+    */
+    virtual void AddCurve(const std::vector<Float3>& points,
+                          const std::string& name,
+                          int layer) = 0;
+
+    /**
+    * Adds an instancer for the leaves of the tree
+    * @param topology The faces and uvs shared by all leaf prototypes
+    * @param name The name of the instancer
+    * @return the sink to receive the prototypes and instances
+    */
+    virtual LeafInstanceSink& AddLeafInstancer(const MeshBuffer& topology,
+                                               const std::string& name) = 0;
+};
+
+/**
+* Reports the progress of generating a tree
+*/
+class TreeProgress
+{
+public:
+
+    /**
+    * Destructor
+    */
+    virtual ~TreeProgress() = default;
+
+    /**
+    * Sets the description of the current step
+    * @param description The text describing the step
+    */
+    virtual void Describe(const char* description) = 0;
+
+    /**
+    * Advances the progress out of a total of 100
+    * @param amount The amount to advance by
+    */
+    virtual void Advance(int amount) = 0;
+
+    /**
+    * @return whether generation should stop
+    */
+    virtual bool IsCancelled() = 0;
+};
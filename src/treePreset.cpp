@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treePreset.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "treePreset.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace
+{
+    /**
+    * A flag and the GUI controls that give each of its values
+    */
+    struct PresetFlag
+    {
+        const char* flag;                       ///< Short name of the flag
+        std::vector<const char*> controls;      ///< GUI control for each value of the flag
+    };
+
+    /**
+    * @return the flags passed by the GUI in TreeGeneratorGUI.mel
+    */
+    const std::vector<PresetFlag>& PresetFlags()
+    {
+        static const std::vector<PresetFlag> flags =
+        {
+            { "-bd", { "gt_BranchDeath" } },
+            { "-i", { "gt_IterationsInput" } },
+            { "-fi", { "gt_LeafTexture" } },
+            { "-l", { "gt_LeafTree", "gt_LeafStart" } },
+            { "-a", { "gt_AngleInput", "gt_AngleVarInput" } },
+            { "-ta", { "gt_AngleInputT", "gt_AngleVarInputT" } },
+            { "-rp", { "gt_RulePre", "gt_RuleStart", "gt_RulePost" } },
+            { "-f", { "gt_ForwardInput", "gt_ForwardVarInput", "gt_ForwardAngInput" } },
+            { "-tf", { "gt_ForwardInputT", "gt_ForwardVarInputT", "gt_ForwardAngInputT" } },
+            { "-m", { "gt_UsePreview", "gt_TreeTips", "gt_Randomize" } },
+            { "-ld", { "gt_LeafBending", "gt_LeafHeight", "gt_LeafWidth", "gt_LeafHeightv", "gt_LeafWidthv" } },
+            { "-cd", { "gt_branchShader", "gt_leafShader", "gt_bumpMapping", "gt_bumpMappingAmount", "gt_uvBleedSpace" } },
+            { "-r", { "gt_RadiusI", "gt_RadiusB", "gt_RadiusDec", "gt_RadiusDecT", "gt_RadiusM" } },
+            { "-fa", { "gt_TrunkFacesInput", "gt_BranchFacesInput", "gt_BranchFacesDecInput" } },
+            { "-c", { "gt_branchSliderL[0]", "gt_branchSliderL[1]", "gt_branchSliderL[2]",
+                      "gt_branchSliderD[0]", "gt_branchSliderD[1]", "gt_branchSliderD[2]" } },
+            { "-r1", { "gt_Rule1Input", "gt_Rule2Input", "gt_Rule3Input", "gt_Rule4Input", "gt_Rule5Input" } },
+            { "-r2", { "gt_Rule6Input", "gt_Rule7Input", "gt_Rule8Input", "gt_Rule9Input", "gt_Rule10Input" } },
+            { "-rc1", { "gt_RuleC1Input", "gt_RuleC2Input", "gt_RuleC3Input", "gt_RuleC4Input", "gt_RuleC5Input" } },
+            { "-rc2", { "gt_RuleC6Input", "gt_RuleC7Input", "gt_RuleC8Input", "gt_RuleC9Input", "gt_RuleC10Input" } },
+            { "-rp1", { "gt_RuleP1Input", "gt_RuleP2Input", "gt_RuleP3Input", "gt_RuleP4Input", "gt_RuleP5Input" } },
+            { "-rp2", { "gt_RuleP6Input", "gt_RuleP7Input", "gt_RuleP8Input", "gt_RuleP9Input", "gt_RuleP10Input" } }
+        };
+        return flags;
+    }
+}
+
+bool TreePreset::Load(const std::string& path)
+{
+    std::ifstream file(path);
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    const size_t folder = path.find_last_of("/\\");
+    m_name = path.substr(folder == std::string::npos ? 0 : folder + 1);
+    m_name = m_name.substr(0, m_name.find_last_of('.'));
+    m_values.clear();
+
+    // Each line is in the form: control -edit -option value "name";
+    std::string line;
+    while(std::getline(file, line))
+    {
+        const size_t end = line.find_last_of('"');
+        const size_t start = end == std::string::npos ? end : line.find_last_of('"', end - 1);
+        const size_t option = line.find(" -", line.find("-edit") + 1);
+        if(start == std::string::npos || option == std::string::npos || option >= start)
+        {
+            continue;
+        }
+
+        const std::string control = line.substr(start + 1, end - start - 1);
+        const size_t valueStart = line.find(' ', option + 1) + 1;
+        std::string value = line.substr(valueStart, start - valueStart);
+        value = value.substr(0, value.find_last_not_of(' ') + 1);
+
+        if(value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        {
+            m_values.emplace_back(control, value.substr(1, value.size() - 2));
+        }
+        else if(line.compare(0, 14, "colorSliderGrp") == 0)
+        {
+            std::istringstream colours(value);
+            std::string colour;
+            for(int i = 0; colours >> colour; ++i)
+            {
+                m_values.emplace_back(control + "[" + std::to_string(i) + "]", colour);
+            }
+        }
+        else
+        {
+            m_values.emplace_back(control, value);
+        }
+    }
+    return !m_values.empty();
+}
+
+const std::string& TreePreset::Name() const
+{
+    return m_name;
+}
+
+std::string TreePreset::Value(const std::string& control) const
+{
+    for(const auto& value : m_values)
+    {
+        if(value.first == control)
+        {
+            return value.second;
+        }
+    }
+    return std::string();
+}
+
+std::vector<std::string> TreePreset::Arguments() const
+{
+    std::vector<std::string> arguments;
+    for(const PresetFlag& flag : PresetFlags())
+    {
+        // Flags with a value missing from the preset keep their defaults
+        std::vector<std::string> values;
+        for(const char* control : flag.controls)
+        {
+            auto value = std::find_if(m_values.begin(), m_values.end(), 
+                [control](const std::pair<std::string, std::string>& value)
+            {
+                return value.first == control;
+            });
+
+            if(value == m_values.end())
+            {
+                break;
+            }
+            values.push_back(value->second);
+        }
+
+        if(values.size() == flag.controls.size())
+        {
+            arguments.push_back(flag.flag);
+            arguments.insert(arguments.end(), values.begin(), values.end());
+        }
+    }
+    return arguments;
+}
@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treePreset.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+* Reads a tree preset saved by the GUI and converts it into the
+* flags the GUI would pass to GenerateTree for the same values
+*/
+class TreePreset
+{
+public:
+
+    /**
+    * Loads a preset from a MEL file
+    * @param path The path to the preset
+    * @return whether the preset could be read
+    */
+    bool Load(const std::string& path);
+
+    /**
+    * @return the name of the preset from its file name
+    */
+    const std::string& Name() const;
+
+    /**
+    * @return the flags and their values for the preset
+    */
+    std::vector<std::string> Arguments() const;
+
+    /**
+    * @param control The name of the GUI control
+    * @return the value of the control or empty if not in the preset
+    */
+    std::string Value(const std::string& control) const;
+
+private:
+
+    std::string m_name;                                             ///< Name of the preset
+    std::vector<std::pair<std::string, std::string>> m_values;      ///< Value for each GUI control
+};
@@ -0,0 +1,40 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeProgress.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "treeProgress.h"
+
+#include <algorithm>
+
+ConsoleProgress::ConsoleProgress(std::ostream& stream) :
+    m_stream(stream)
+{
+}
+
+void ConsoleProgress::Describe(const char* description)
+{
+    m_stream << description << " " << m_progress << "%" << std::endl;
+}
+
+void ConsoleProgress::Advance(int amount)
+{
+    m_progress = std::min(100, m_progress + amount);
+}
+
+bool ConsoleProgress::IsCancelled()
+{
+    return false;
+}
+
+void SilentProgress::Describe(const char*)
+{
+}
+
+void SilentProgress::Advance(int)
+{
+}
+
+bool SilentProgress::IsCancelled()
+{
+    return false;
+}
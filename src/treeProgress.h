@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeProgress.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeOutput.h"
+
+#include <ostream>
+
+/**
+* Writes the progress of generating a tree to the console
+*/
+class ConsoleProgress : public TreeProgress
+{
+public:
+
+    /**
+    * Constructor
+    * @param stream The stream to write progress to
+    */
+    explicit ConsoleProgress(std::ostream& stream);
+
+    virtual void Describe(const char* description) override;
+    virtual void Advance(int amount) override;
+    virtual bool IsCancelled() override;
+
+private:
+
+    std::ostream& m_stream;     ///< The stream to write progress to
+    int m_progress = 0;         ///< Progress out of a total of 100
+};
+
+/**
+* Ignores the progress of generating a tree
+*/
+class SilentProgress : public TreeProgress
+{
+public:
+
+    virtual void Describe(const char* description) override;
+    virtual void Advance(int amount) override;
+    virtual bool IsCancelled() override;
+};
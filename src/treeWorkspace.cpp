@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeWorkspace.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "treeWorkspace.h"
+#include "threadPool.h"
+
+namespace
+{
+    /**
+    * Empties a buffer keeping its memory
+    */
+    void Empty(MeshBuffer& mesh)
+    {
+        mesh.Clear();
+    }
+
+    void Empty(std::vector<int>& values)
+    {
+        values.clear();
+    }
+
+    void Empty(Disk& disk)
+    {
+        disk.points.clear();
+    }
+
+    /**
+    * Resizes a list of buffers and empties each of them
+    * @param buffers The buffers to reuse
+    * @param count The number of buffers required
+    * @return the buffers
+    */
+    template<typename T> std::vector<T>& Reuse(std::vector<T>& buffers, size_t count)
+    {
+        buffers.resize(count);
+        for(T& buffer : buffers)
+        {
+            Empty(buffer);
+        }
+        return buffers;
+    }
+}
+
+TreeWorkspace::TreeWorkspace() = default;
+
+TreeWorkspace::~TreeWorkspace() = default;
+
+void TreeWorkspace::Reset()
+{
+    rule.clear();
+    scratchRule.clear();
+    skeleton.Clear();
+    leaves.clear();
+    points.clear();
+    randoms.clear();
+    instances.clear();
+    leafTopology.Clear();
+    offsets.clear();
+    frames.clear();
+    topologies.Reset();
+    branchTopologies.clear();
+    lodSkeleton.Clear();
+    lodBranches.clear();
+    m_partsUsed = 0;
+}
+
+void TreeWorkspace::Release()
+{
+    // Clearing keeps the memory so buffers are swapped or replaced with empty ones
+    m_threads.reset();
+    m_parts.clear();
+    m_partsUsed = 0;
+    std::string().swap(rule);
+    std::string().swap(scratchRule);
+    skeleton = Skeleton();
+    std::vector<Leaf>().swap(leaves);
+    std::vector<Float3>().swap(points);
+    std::vector<float>().swap(randoms);
+    std::vector<LeafInstance>().swap(instances);
+    leafTopology = MeshBuffer();
+    std::vector<MeshSize>().swap(offsets);
+    std::vector<RingFrame>().swap(frames);
+    topologies.Release();
+    std::vector<int>().swap(branchTopologies);
+    lodSkeleton = Skeleton();
+    std::vector<int>().swap(lodBranches);
+    std::vector<MeshBuffer>().swap(m_branchMeshes);
+    std::vector<MeshBuffer>().swap(m_leafMeshes);
+    std::vector<std::vector<int>>().swap(m_branchFaces);
+    std::vector<Disk>().swap(m_disks);
+}
+
+ThreadPool& TreeWorkspace::Threads()
+{
+    if(!m_threads)
+    {
+        m_threads = std::make_unique<ThreadPool>();
+    }
+    return *m_threads;
+}
+
+SkeletonPart& TreeWorkspace::AcquirePart()
+{
+    std::lock_guard<std::mutex> lock(m_partsMutex);
+    if(m_partsUsed == m_parts.size())
+    {
+        m_parts.push_back(std::make_unique<SkeletonPart>());
+    }
+
+    SkeletonPart& part = *m_parts[m_partsUsed++];
+    part.Clear();
+    return part;
+}
+
+size_t TreeWorkspace::PartCount()
+{
+    std::lock_guard<std::mutex> lock(m_partsMutex);
+    return m_partsUsed;
+}
+
+std::vector<MeshBuffer>& TreeWorkspace::BranchMeshes(size_t count)
+{
+    return Reuse(m_branchMeshes, count);
+}
+
+std::vector<MeshBuffer>& TreeWorkspace::LeafMeshes(size_t count)
+{
+    return Reuse(m_leafMeshes, count);
+}
+
+std::vector<std::vector<int>>& TreeWorkspace::BranchFaces(size_t count)
+{
+    return Reuse(m_branchFaces, count);
+}
+
+std::vector<Disk>& TreeWorkspace::Disks(size_t count)
+{
+    return Reuse(m_disks, count);
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treeWorkspace.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeComponents.h"
+#include "leafInstancer.h"
+#include "topologyCache.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+/**
+* Memory reused by every tree generated with the workspace. Buffers are emptied
+* for each tree but keep the capacity of the largest tree generated so far,
+* so generating similar trees again barely allocates. Only one tree may be
+* generated with the workspace at a time
+*/
+class TreeWorkspace
+{
+public:
+
+    /**
+    * Constructor
+    */
+    TreeWorkspace();
+
+    /**
+    * Destructor
+    */
+    ~TreeWorkspace();
+
+    /**
+    * Empties all buffers for a new tree, keeping their memory
+    */
+    void Reset();
+
+    /**
+    * Frees the memory of all buffers and stops the workers
+    */
+    void Release();
+
+    /**
+    * @return the workers for generating the tree, started on first use
+    */
+    ThreadPool& Threads();
+
+    /**
+    * Gets an empty part of the skeleton for a turtle task. Safe to call from the workers
+    * @return the part, owned by the workspace and kept until the next reset
+    */
+    SkeletonPart& AcquirePart();
+
+    /**
+    * @return the number of parts given out since the reset
+    */
+    size_t PartCount();
+
+    /**
+    * Gets empty meshes to fill with branches, reusing the memory of the meshes filled before
+    * @param count The number of meshes required
+    * @return the meshes
+    */
+    std::vector<MeshBuffer>& BranchMeshes(size_t count);
+
+    /**
+    * Gets empty meshes to fill with leaves, reusing the memory of the meshes filled before
+    * @param count The number of meshes required
+    * @return the meshes
+    */
+    std::vector<MeshBuffer>& LeafMeshes(size_t count);
+
+    /**
+    * Gets empty lists of the faces of each branch for the meshes
+    * @param count The number of meshes required
+    * @return the lists of branch faces
+    */
+    std::vector<std::vector<int>>& BranchFaces(size_t count);
+
+    /**
+    * Gets empty disks to fill with the ring of each layer
+    * @param count The number of layers
+    * @return the disks
+    */
+    std::vector<Disk>& Disks(size_t count);
+
+    std::string rule;                       ///< The derived rule string
+    std::string scratchRule;                ///< The rule string being rewritten into
+    Skeleton skeleton;                      ///< All branches of the tree including the trunk
+    std::vector<Leaf> leaves;               ///< All leaves of the tree
+    std::vector<Float3> points;             ///< Points of a curve
+    std::vector<float> randoms;             ///< Random values for all leaves
+    std::vector<LeafInstance> instances;    ///< Leaves placed by the instancer
+    MeshBuffer leafTopology;                ///< Faces and uvs shared by all leaves
+    std::vector<MeshSize> offsets;          ///< Where each branch or leaf starts in its merged mesh
+    std::vector<RingFrame> frames;          ///< Orientation of the ring around each section
+    TopologyCache topologies;               ///< Faces and uvs shared by branches of the same shape
+    std::vector<int> branchTopologies;      ///< Index of the shared topology of each branch
+    Skeleton lodSkeleton;                   ///< Branches kept by the level of detail being meshed
+    std::vector<int> lodBranches;           ///< Index in the skeleton of each branch kept by the level of detail
+
+private:
+
+    /**
+    * Prevent copying
+    */
+    TreeWorkspace(const TreeWorkspace&) = delete;
+    TreeWorkspace& operator=(const TreeWorkspace&) = delete;
+
+    std::unique_ptr<ThreadPool> m_threads;              ///< Workers for splitting up generation
+    std::vector<std::unique_ptr<SkeletonPart>> m_parts; ///< Parts of the skeleton for turtle tasks
+    size_t m_partsUsed = 0;                             ///< Number of parts given out since the reset
+    std::mutex m_partsMutex;                            ///< Guards giving out parts from the workers
+    std::vector<MeshBuffer> m_branchMeshes;             ///< Meshes being filled with branches
+    std::vector<MeshBuffer> m_leafMeshes;               ///< Meshes being filled with leaves
+    std::vector<std::vector<int>> m_branchFaces;        ///< Faces of each branch for each merged mesh
+    std::vector<Disk> m_disks;                          ///< Ring of vertices for each layer
+};
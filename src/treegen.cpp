@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - treegen.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "commandLine.h"
+#include "objWriter.h"
+#include "treeBuilder.h"
+#include "treeProgress.h"
+#include "profiler.h"
+
+#include <fstream>
+#include <iostream>
+
+/**
+* Generates a tree without Maya and writes it as an OBJ
+*/
+int main(int argc, char** argv)
+{
+    CommandLineArguments arguments;
+    if(!arguments.Parse(argc, argv))
+    {
+        std::cerr << arguments.Error() << std::endl;
+        CommandLineArguments::PrintUsage(std::cerr);
+        return 1;
+    }
+
+    if(arguments.HelpRequested())
+    {
+        CommandLineArguments::PrintUsage(std::cout);
+        return 0;
+    }
+
+    TreeParameters parameters;
+    arguments.Read(parameters);
+
+    // Estimates only build the skeleton and write no geometry
+    bool estimate = false;
+    arguments.Get("-es", 0, estimate);
+    if(estimate)
+    {
+        ConsoleProgress progress(std::cerr);
+        TreeBuilder builder(parameters, progress);
+        if(!builder.BuildSkeleton())
+        {
+            std::cerr << "Failed to generate the tree" << std::endl;
+            return 1;
+        }
+        builder.Estimate().WriteReport(std::cout);
+        std::cout << std::endl;
+        return 0;
+    }
+
+    std::ofstream file(arguments.OutputFile());
+    if(!file.is_open())
+    {
+        std::cerr << "Could not open " << arguments.OutputFile() << std::endl;
+        return 1;
+    }
+
+    bool profile = false;
+    std::string traceFile;
+    arguments.Get("-pf", 0, profile);
+    arguments.Get("-trf", 0, traceFile);
+    Profiler profiler;
+
+    ConsoleProgress progress(std::cerr);
+    TreeBuilder builder(parameters, progress);
+    builder.SetProfiler(profile ? &profiler : nullptr);
+    ObjWriter writer(file);
+
+    bool succeeded = false;
+    {
+        Profiler::Scope scope(profile ? &profiler : nullptr, "GenerateTree");
+        succeeded = builder.BuildSkeleton() && builder.CreateGeometry(writer, "tf_tree_1");
+    }
+
+    if(profile)
+    {
+        profiler.WriteReport(std::cout);
+        std::cout << std::endl;
+
+        if(!traceFile.empty())
+        {
+            std::ofstream trace(traceFile);
+            profiler.WriteTrace(trace);
+        }
+    }
+
+    if(!succeeded)
+    {
+        std::cerr << "Failed to generate the tree" << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Seed: " << parameters.tree.seed << std::endl;
+    std::cerr << "Wrote " << arguments.OutputFile() << std::endl;
+    return 0;
+}
@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - branchDeathTests.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "testHelpers.h"
+#include "recordingOutput.h"
+#include "treeBuilder.h"
+#include "ruleStream.h"
+#include "ruleSystem.h"
+#include "randomGenerator.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const char* DEFAULT_RULE = "[>FGLLLFGLLLFLLLA]^^^^^[>FGLLLFGLLLFLLLA]^^^^^^^[>FGLLLFGLLLFLLLA]";
+    const char* NESTED_RULE = "F[+X[L]][-X[L]]FX";
+    const unsigned int SEEDS[] = { 0, 1, 7, 42, 12345 };   ///< Seeds of every rule derived
+    const unsigned int DEATHS[] = { 0, 10, 40, 75 };       ///< Branch death probabilities from 0-100%
+
+    /**
+    * Derives a rule without pruning any branches
+    * @param axiom The symbols to start deriving from
+    * @param symbol The rule character to replace
+    * @param production The symbols to replace the rule character with
+    * @param iterations The number of rewrite iterations
+    * @param seed The seed for the derivation
+    * @return the derived rule
+    */
+    std::string Derive(const std::string& axiom,
+                       char symbol,
+                       const std::string& production,
+                       unsigned int iterations,
+                       unsigned int seed)
+    {
+        RuleSystem rules;
+        rules.SetSeed(seed);
+        rules.AddRule(symbol, production, 100);
+
+        std::string rule = axiom;
+        std::string result;
+        for(unsigned int i = 0; i < iterations; ++i)
+        {
+            rules.Rewrite(rule, result, i);
+            rule.swap(result);
+        }
+        return rule;
+    }
+
+    /**
+    * Reads a rule the way the turtle did before branches were indexed, walking
+    * forward one symbol at a time to the matching ] of each branch that dies
+    * @param rule The rule to read
+    * @param random Decides whether each branch dies
+    * @param death The probability from 0-100% of a branch dying
+    * @return the symbols read
+    */
+    std::string WalkRule(const std::string& rule, RandomStream random, unsigned int death)
+    {
+        std::string read;
+        for(size_t index = 0; index < rule.size(); ++index)
+        {
+            read += rule[index];
+            if(rule[index] == '[' && random.Generate(0, 100) < static_cast<int>(death))
+            {
+                // Remove all symbols up until corresponding ]
+                int searchnumber = 1;
+                while(index + 1 < rule.size())
+                {
+                    ++index;
+                    if(rule[index] == '[')
+                    {
+                        searchnumber++;
+                    }
+                    if(rule[index] == ']')
+                    {
+                        searchnumber--;
+                    }
+                    if(searchnumber == 0)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+        return read;
+    }
+
+    /**
+    * Reads a rule through a rule reader, skipping each branch that dies
+    * @param rule The rule to read
+    * @param jumpBranches Whether to skip branches through the bracket jump table
+    * @param random Decides whether each branch dies
+    * @param death The probability from 0-100% of a branch dying
+    * @return the symbols read
+    */
+    std::string ReadRule(const std::string& rule,
+                         bool jumpBranches,
+                         RandomStream random,
+                         unsigned int death)
+    {
+        RuleReader reader(rule, jumpBranches);
+        std::string read;
+        char symbol = 0;
+        while(reader.Next(symbol))
+        {
+            read += symbol;
+            if(symbol == '[' && random.Generate(0, 100) < static_cast<int>(death))
+            {
+                reader.SkipBranch();
+            }
+        }
+        return read;
+    }
+
+    /**
+    * Checks skipping dead branches through the jump table reads the same
+    * symbols as walking to the matching bracket for the same decisions
+    * @param rule The rule to read
+    */
+    void CheckSkipBranch(const std::string& rule)
+    {
+        for(unsigned int seed : SEEDS)
+        {
+            for(unsigned int death : DEATHS)
+            {
+                const RandomStream random(seed, 1);
+                const std::string walked = WalkRule(rule, random, death);
+                TEST_CHECK(ReadRule(rule, true, random, death) == walked);
+                TEST_CHECK(ReadRule(rule, false, random, death) == walked);
+                TEST_CHECK(death > 0 || walked == rule);
+            }
+        }
+    }
+
+    /**
+    * Checks pruning branches while deriving gives the same rule as rewriting every
+    * symbol in full and then walking each replacement to remove the branches that die
+    * @param axiom The symbols to start deriving from
+    * @param symbol The rule character to replace
+    * @param production The symbols to replace the rule character with
+    * @param iterations The number of rewrite iterations
+    */
+    void CheckPruning(const std::string& axiom,
+                      char symbol,
+                      const std::string& production,
+                      unsigned int iterations)
+    {
+        for(unsigned int seed : SEEDS)
+        {
+            for(unsigned int death : DEATHS)
+            {
+                RuleSystem pruned;
+                pruned.SetSeed(seed);
+                pruned.SetBranchDeath(death);
+                pruned.AddRule(symbol, production, 100);
+
+                RuleSystem full;
+                full.SetSeed(seed);
+                full.AddRule(symbol, production, 100);
+
+                std::string rule = axiom;
+                std::string result;
+                for(unsigned int generation = 0; generation < iterations; ++generation)
+                {
+                    std::string walked;
+                    for(size_t index = 0; index < rule.size(); ++index)
+                    {
+                        const RuleSystem::Replacement replacement =
+                            full.Replace(generation, index, rule[index]);
+                        TEST_CHECK(replacement.jumps == nullptr);
+
+                        // Only branches closed within the replacement can die
+                        const std::string symbols(replacement.symbols, replacement.length);
+                        for(size_t offset = 0; offset < symbols.size(); ++offset)
+                        {
+                            const size_t start = offset;
+                            if(symbols[offset] == '[' && pruned.BranchDies(generation, index, offset))
+                            {
+                                int searchnumber = 1;
+                                while(offset + 1 < symbols.size())
+                                {
+                                    ++offset;
+                                    if(symbols[offset] == '[')
+                                    {
+                                        searchnumber++;
+                                    }
+                                    if(symbols[offset] == ']')
+                                    {
+                                        searchnumber--;
+                                    }
+                                    if(searchnumber == 0)
+                                    {
+                                        break;
+                                    }
+                                }
+
+                                if(searchnumber == 0)
+                                {
+                                    continue;
+                                }
+                                offset = start;
+                            }
+                            walked += symbols[offset];
+                        }
+                    }
+
+                    pruned.Rewrite(rule, result, generation);
+                    TEST_CHECK(result == walked);
+                    rule.swap(result);
+                }
+            }
+        }
+    }
+
+    /**
+    * Checks a tree with branches pruned while deriving builds a branch for every
+    * branch left in the rule, as the turtle no longer kills any branches itself
+    * @param seed The seed of the tree
+    * @param death The probability from 0-100% of a branch dying
+    */
+    void CheckPrunedTree(unsigned int seed, unsigned int death)
+    {
+        TreeParameters parameters;
+        parameters.iterations = 5;
+        parameters.tree.seed = seed;
+        parameters.tree.branchDeathProbability = death;
+        parameters.tree.pruneBranches = true;
+
+        RuleSystem rules;
+        rules.SetSeed(seed);
+        rules.SetBranchDeath(death);
+        rules.AddRule(parameters.ruleIDs[0][0], parameters.ruleStrings[0], parameters.ruleChances[0]);
+
+        std::string rule = parameters.tree.axiom;
+        std::string result;
+        for(unsigned int i = 0; i < parameters.iterations; ++i)
+        {
+            rules.Rewrite(rule, result, i);
+            rule.swap(result);
+        }
+        rule = parameters.tree.prerule + rule + parameters.tree.postrule;
+
+        SilentProgress progress;
+        TreeBuilder builder(parameters, progress);
+        TEST_CHECK(builder.BuildSkeleton());
+        const TreeEstimate estimate = builder.Estimate();
+        TEST_CHECK(estimate.symbols == rule.size());
+        TEST_CHECK(estimate.branches == static_cast<size_t>(std::count(rule.begin(), rule.end(), '[')) + 1);
+    }
+}
+
+int main()
+{
+    // Derived rules and rules with unmatched brackets
+    CheckSkipBranch(Derive("A", 'A', DEFAULT_RULE, 5, 0));
+    CheckSkipBranch(Derive("X", 'X', NESTED_RULE, 6, 0));
+    CheckSkipBranch("F[[A]F[B[C]]]]F[D[E");
+    CheckSkipBranch("]]F[A]][[");
+
+    CheckPruning("A", 'A', DEFAULT_RULE, 6);
+    CheckPruning("X", 'X', NESTED_RULE, 6);
+    CheckPruning("X", 'X', "F[+X[L]F[-X", 6);
+
+    // Pruning during derivation rolls on each symbol's position in the rule
+    // while the turtle rolls on the random stream of the branch it is in, so
+    // the same probability kills different branches for the same seed. The
+    // trees are only required to agree with the rule each derives
+    for(unsigned int seed : SEEDS)
+    {
+        CheckPrunedTree(seed, 0);
+        CheckPrunedTree(seed, 10);
+        CheckPrunedTree(seed, 40);
+    }
+    return Test::Result("branchDeathTests");
+}
@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - leafInstancerTests.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "testHelpers.h"
+#include "recordingOutput.h"
+#include "treeBuilder.h"
+#include "leafInstancer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const float TOLERANCE = 1.0e-3f;    ///< Largest difference allowed from rebuilding a leaf through euler angles
+
+    /**
+    * Generates a tree, recording everything it creates
+    * @param parameters The parameters of the tree
+    * @param output Filled with the geometry of the tree
+    */
+    void Generate(const TreeParameters& parameters, RecordingOutput& output)
+    {
+        SilentProgress progress;
+        TreeBuilder builder(parameters, progress);
+        TEST_CHECK(builder.BuildSkeleton());
+        TEST_CHECK(builder.CreateGeometry(output, "tree"));
+    }
+
+    /**
+    * @return the largest difference along any axis between two points
+    */
+    float Difference(const Float3& a, const Float3& b)
+    {
+        return std::max(std::fabs(a.x - b.x), std::max(std::fabs(a.y - b.y), std::fabs(a.z - b.z)));
+    }
+
+    /**
+    * Checks the prototypes sent to a recording sink
+    * @param bendAmount Amount to bend the leaf
+    * @param prototypes The number of prototypes expected
+    */
+    void CheckPrototypes(float bendAmount, size_t prototypes)
+    {
+        LeafInstancer instancer(2.0f, 4.0f, 1.0f, 1.0f, bendAmount);
+        RecordingSink sink;
+        instancer.CreatePrototypes(sink);
+        TEST_CHECK(sink.prototypes.size() == prototypes);
+        TEST_CHECK(instancer.PrototypeCount() == prototypes);
+        for(const std::vector<Float3>& prototype : sink.prototypes)
+        {
+            TEST_CHECK(prototype.size() == static_cast<size_t>(instancer.VertexCount()));
+        }
+    }
+
+    /**
+    * Checks that each instance placed over its prototype gives the baked leaf of the same seed
+    * @param bendAmount Amount to bend the leaves
+    */
+    void CheckInstances(double bendAmount)
+    {
+        TreeParameters parameters;
+        parameters.iterations = 3;
+        parameters.tree.seed = 7;
+        parameters.mesh.meshMode = MESH_PER_TREE;
+        parameters.leaf.bendAmount = bendAmount;
+
+        RecordingOutput baked;
+        parameters.leaf.leafMode = LEAF_PER_LEAF;
+        Generate(parameters, baked);
+
+        RecordingOutput instanced;
+        parameters.leaf.leafMode = LEAF_INSTANCED;
+        Generate(parameters, instanced);
+
+        std::vector<const MeshBuffer*> leaves;
+        for(const RecordedMesh& mesh : baked.meshes)
+        {
+            if(mesh.leaves)
+            {
+                leaves.push_back(&mesh.mesh);
+            }
+        }
+
+        const RecordingSink& sink = instanced.sink;
+        TEST_CHECK(instanced.instancers == 1);
+        TEST_CHECK(sink.prototypes.size() == (bendAmount != 0.0 ? 9u : 1u));
+        TEST_CHECK(!leaves.empty());
+        TEST_CHECK(sink.instances.size() == leaves.size());
+        if(sink.instances.size() != leaves.size())
+        {
+            return;
+        }
+
+        // Prototypes only hold a few bend levels so the middle of a bent
+        // leaf may be up to half a level away from the baked leaf's bend
+        const float bendTolerance = static_cast<float>(bendAmount) / 2.0f + TOLERANCE;
+
+        float largest = 0.0f;
+        float largestBend = 0.0f;
+        for(size_t i = 0; i < leaves.size(); ++i)
+        {
+            const LeafInstance& instance = sink.instances[i];
+            TEST_CHECK(instance.prototype < sink.prototypes.size());
+            if(instance.prototype >= sink.prototypes.size())
+            {
+                continue;
+            }
+
+            const std::vector<Float3>& prototype = sink.prototypes[instance.prototype];
+            const std::vector<Float3>& vertices = leaves[i]->vertices;
+            TEST_CHECK(prototype.size() == vertices.size());
+
+            const Matrix transform = LeafInstancer::CreateTransform(instance);
+            for(size_t v = 0; v < std::min(prototype.size(), vertices.size()); ++v)
+            {
+                const float difference = Difference(transform * prototype[v], vertices[v]);
+                const bool middle = prototype.size() == 6 && (v == 2 || v == 3);
+                if(middle)
+                {
+                    largestBend = std::max(largestBend, difference);
+                }
+                else
+                {
+                    largest = std::max(largest, difference);
+                }
+            }
+        }
+
+        TEST_CHECK(largest <= TOLERANCE);
+        TEST_CHECK(largestBend <= bendTolerance);
+    }
+}
+
+int main()
+{
+    CheckPrototypes(1.0f, 9);
+    CheckPrototypes(0.0f, 1);
+    CheckInstances(0.0);
+    CheckInstances(1.0);
+    CheckInstances(2.5);
+    return Test::Result("leafInstancerTests");
+}
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - levelOfDetailTests.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "testHelpers.h"
+#include "recordingOutput.h"
+#include "treeBuilder.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const int LEVELS = 4;   ///< Levels of detail created by the tests
+
+    /**
+    * Counts of the branch meshes of a level of detail
+    */
+    struct LevelCounts
+    {
+        size_t branches = 0;    ///< Branches meshed
+        size_t sections = 0;    ///< Rings of all branches meshed
+        size_t vertices = 0;    ///< Vertices of all branches meshed
+    };
+
+    /**
+    * @param name The name of a mesh
+    * @return the level of detail of the mesh or -1 if it has none
+    */
+    int MeshLevel(const std::string& name)
+    {
+        const size_t suffix = name.rfind("_LOD");
+        return suffix == std::string::npos ? -1 : std::stoi(name.substr(suffix + 4));
+    }
+
+    /**
+    * Generates a tree from a skeleton built once, recording everything it creates
+    * @param parameters The parameters of the tree
+    * @param output Filled with the geometry of the tree
+    * @param estimate Filled with the counts estimated for the tree
+    */
+    void Generate(const TreeParameters& parameters, RecordingOutput& output, TreeEstimate& estimate)
+    {
+        SilentProgress progress;
+        TreeBuilder builder(parameters, progress);
+        TEST_CHECK(builder.BuildSkeleton());
+        estimate = builder.Estimate();
+        TEST_CHECK(builder.CreateGeometry(output, "tree"));
+    }
+
+    /**
+    * @return the leaf meshes of a tree in the order they were created
+    */
+    std::vector<const RecordedMesh*> Leaves(const RecordingOutput& output)
+    {
+        std::vector<const RecordedMesh*> leaves;
+        for(const RecordedMesh& mesh : output.meshes)
+        {
+            if(mesh.leaves)
+            {
+                leaves.push_back(&mesh);
+            }
+        }
+        return leaves;
+    }
+
+    /**
+    * Checks each level of detail has fewer branches and sections than the last
+    * and that all levels share the leaves of the full tree
+    * @param seed The seed of the tree
+    * @param iterations The number of rewrite iterations
+    */
+    void CheckLevels(unsigned int seed, unsigned int iterations)
+    {
+        TreeParameters parameters;
+        parameters.iterations = iterations;
+        parameters.tree.seed = seed;
+        parameters.mesh.meshMode = MESH_PER_BRANCH;
+        parameters.mesh.capEnds = false;
+        parameters.leaf.leafMode = LEAF_PER_LAYER;
+
+        TreeEstimate single;
+        RecordingOutput full;
+        Generate(parameters, full, single);
+
+        TreeEstimate estimate;
+        RecordingOutput reduced;
+        parameters.mesh.lods = LEVELS;
+        Generate(parameters, reduced, estimate);
+
+        // Without caps each ring of a branch has a vertex for each face
+        // between rings, so the rings are the vertices over the extra vertices
+        std::vector<LevelCounts> levels(LEVELS);
+        size_t branchVertices = 0;
+        for(const RecordedMesh& mesh : reduced.meshes)
+        {
+            if(mesh.leaves)
+            {
+                continue;
+            }
+
+            const int level = MeshLevel(mesh.name);
+            TEST_CHECK(level >= 0 && level < LEVELS);
+            if(level < 0 || level >= LEVELS)
+            {
+                continue;
+            }
+
+            const size_t vertices = mesh.mesh.vertices.size();
+            const size_t faces = mesh.mesh.polycounts.size();
+            TEST_CHECK(vertices > faces);
+            ++levels[level].branches;
+            levels[level].sections += vertices / (vertices - faces);
+            levels[level].vertices += vertices;
+            branchVertices += vertices;
+        }
+
+        // The first level is the full tree
+        size_t fullVertices = 0;
+        size_t fullBranches = 0;
+        for(const RecordedMesh& mesh : full.meshes)
+        {
+            if(!mesh.leaves)
+            {
+                ++fullBranches;
+                fullVertices += mesh.mesh.vertices.size();
+                TEST_CHECK(MeshLevel(mesh.name) < 0);
+            }
+        }
+        TEST_CHECK(levels[0].branches == fullBranches);
+        TEST_CHECK(levels[0].vertices == fullVertices);
+
+        for(int level = 1; level < LEVELS; ++level)
+        {
+            TEST_CHECK(levels[level].branches > 0);
+            TEST_CHECK(levels[level].branches < levels[level - 1].branches);
+            TEST_CHECK(levels[level].sections < levels[level - 1].sections);
+            TEST_CHECK(levels[level].vertices < levels[level - 1].vertices);
+        }
+
+        // The estimate counts every level from the same skeleton
+        TEST_CHECK(estimate.branches == single.branches);
+        TEST_CHECK(estimate.sections == single.sections);
+        TEST_CHECK(estimate.branchVertices == branchVertices);
+
+        // Leaves are created once for all levels exactly as for the full tree
+        const std::vector<const RecordedMesh*> fullLeaves = Leaves(full);
+        const std::vector<const RecordedMesh*> sharedLeaves = Leaves(reduced);
+        TEST_CHECK(!fullLeaves.empty());
+        TEST_CHECK(sharedLeaves.size() == fullLeaves.size());
+        for(size_t i = 0; i < std::min(sharedLeaves.size(), fullLeaves.size()); ++i)
+        {
+            TEST_CHECK(sharedLeaves[i]->name == fullLeaves[i]->name);
+            TEST_CHECK(sharedLeaves[i]->mesh.vertices == fullLeaves[i]->mesh.vertices);
+            TEST_CHECK(sharedLeaves[i]->mesh.indices == fullLeaves[i]->mesh.indices);
+        }
+    }
+}
+
+int main()
+{
+    CheckLevels(3, 5);
+    CheckLevels(9, 6);
+    CheckLevels(42, 7);
+    return Test::Result("levelOfDetailTests");
+}
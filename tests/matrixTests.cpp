@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - matrixTests.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "testHelpers.h"
+#include "matrix.h"
+
+#include <cstring>
+#include <vector>
+
+#if defined(TREE_REQUIRE_SIMD) && !defined(TREE_SIMD_SSE)
+#error The SIMD configuration of the tests must use the SSE path
+#endif
+
+namespace
+{
+    const size_t MAX_OFFSET = 3;    ///< Largest offset of the first point from the start of the buffer
+    const float SENTINEL = -12345.0f; ///< Value of the points after the range which must not be written
+
+    /**
+    * Generates repeatable values spread over several magnitudes
+    */
+    class Values
+    {
+    public:
+
+        /**
+        * @return the next value
+        */
+        float Next()
+        {
+            m_state = (m_state * 1664525u) + 1013904223u;
+            const float unit = static_cast<float>(m_state >> 8) / static_cast<float>(1 << 24);
+            const float scales[] = { 0.001f, 1.0f, 37.5f, 1000.0f };
+            return ((unit * 2.0f) - 1.0f) * scales[(m_state >> 4) & 3];
+        }
+
+    private:
+
+        unsigned int m_state = 12345u;  ///< Current state of the generator
+    };
+
+    /**
+    * @return whether the points are identical bit for bit
+    */
+    bool Identical(const Float3* a, const Float3* b, size_t count)
+    {
+        return count == 0 || memcmp(a, b, sizeof(Float3) * count) == 0;
+    }
+
+    /**
+    * Transforms the points through both paths, out of place and in place
+    * @param mat The matrix to transform with
+    * @param points The points to transform
+    */
+    void CheckTransform(const Matrix& mat, const std::vector<Float3>& points)
+    {
+        const size_t count = points.size();
+        for(size_t offset = 0; offset <= MAX_OFFSET; ++offset)
+        {
+            // Offsets move the points off any alignment of the buffer
+            std::vector<Float3> input(offset + count + 1, Float3(SENTINEL, SENTINEL, SENTINEL));
+            std::copy(points.begin(), points.end(), input.begin() + offset);
+            std::vector<Float3> simd(input);
+            std::vector<Float3> scalar(input);
+
+            TransformPoints(mat, &input[offset], &simd[offset], count);
+            TransformPointsScalar(mat, &input[offset], &scalar[offset], count);
+            TEST_CHECK(Identical(&simd[0], &scalar[0], simd.size()));
+            TEST_CHECK(Identical(&input[offset], &points[0], count));
+
+            // Points before and after the range are left alone
+            TEST_CHECK(Identical(&simd[0], &input[0], offset));
+            TEST_CHECK(simd.back().x == SENTINEL && simd.back().y == SENTINEL && simd.back().z == SENTINEL);
+
+            // In place gives the same points as out of place
+            std::vector<Float3> inPlace(input);
+            TransformPoints(mat, &inPlace[offset], &inPlace[offset], count);
+            TEST_CHECK(Identical(&inPlace[0], &scalar[0], inPlace.size()));
+
+            std::vector<Float3> scalarInPlace(input);
+            TransformPointsScalar(mat, &scalarInPlace[offset], &scalarInPlace[offset], count);
+            TEST_CHECK(Identical(&scalarInPlace[0], &scalar[0], scalarInPlace.size()));
+        }
+    }
+}
+
+int main()
+{
+    Values values;
+
+    std::vector<Matrix> matrices;
+    matrices.push_back(Matrix());
+    matrices.push_back(Matrix::CreateRotateArbitrary(Float3(0.3f, 0.8f, -0.52f).GetNormalized(), 1.2f));
+
+    Matrix ring;
+    ring.SetRight(Float3(0.4f, 0.0f, 0.1f));
+    ring.SetUp(Float3(0.0f, 0.3f, 0.2f));
+    ring.SetForward(Float3(-0.1f, 0.2f, 0.5f));
+    ring.SetPosition(Float3(10.0f, -250.0f, 3.5f));
+    matrices.push_back(ring);
+
+    for(int i = 0; i < 4; ++i)
+    {
+        matrices.push_back(Matrix(values.Next(), values.Next(), values.Next(), values.Next(),
+                                  values.Next(), values.Next(), values.Next(), values.Next(),
+                                  values.Next(), values.Next(), values.Next(), values.Next()));
+    }
+
+    // Counts either side of the four wide blocks with every length of remainder
+    std::vector<size_t> counts;
+    for(size_t count = 0; count < 20; ++count)
+    {
+        counts.push_back(count);
+    }
+    counts.push_back(31);
+    counts.push_back(64);
+    counts.push_back(257);
+
+    for(const Matrix& mat : matrices)
+    {
+        for(size_t count : counts)
+        {
+            std::vector<Float3> points(count);
+            for(Float3& point : points)
+            {
+                point.Set(values.Next(), values.Next(), values.Next());
+            }
+            CheckTransform(mat, points);
+        }
+    }
+
+#ifdef TREE_SIMD_SSE
+    return Test::Result("matrixTests (SSE)");
+#else
+    return Test::Result("matrixTests (scalar)");
+#endif
+}
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - recordingOutput.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "treeOutput.h"
+#include "treeProgress.h"
+
+#include <string>
+#include <vector>
+
+/**
+* A mesh received by the recording output
+*/
+struct RecordedMesh
+{
+    MeshBuffer mesh;        ///< The geometry of the mesh
+    std::string name;       ///< The name of the mesh
+    int layer;              ///< The layer the mesh exists in or -1 for the whole tree
+    bool leaves;            ///< Whether the mesh holds leaves rather than branches
+};
+
+/**
+* @return whether two meshes hold exactly the same geometry
+*/
+inline bool SameMesh(const MeshBuffer& a, const MeshBuffer& b)
+{
+    return a.vertices == b.vertices &&
+        a.polycounts == b.polycounts &&
+        a.indices == b.indices &&
+        a.uvIDs == b.uvIDs &&
+        a.uCoord == b.uCoord &&
+        a.vCoord == b.vCoord;
+}
+
+/**
+* @return whether two leaf instances place exactly the same leaf
+*/
+inline bool SameInstance(const LeafInstance& a, const LeafInstance& b)
+{
+    return a.prototype == b.prototype &&
+        a.position == b.position &&
+        a.rotation == b.rotation &&
+        a.scale == b.scale;
+}
+
+/**
+* Keeps the prototypes and instances of instanced leaves
+*/
+class RecordingSink : public LeafInstanceSink
+{
+public:
+
+    /**
+    * Keeps a leaf prototype
+    * @param vertices The local vertices of the prototype
+    */
+    virtual void AddPrototype(const std::vector<Float3>& vertices) override
+    {
+        prototypes.push_back(vertices);
+    }
+
+    /**
+    * Keeps the transforms of every instanced leaf
+    * @param leafInstances The transform for each leaf
+    */
+    virtual void SetInstances(const std::vector<LeafInstance>& leafInstances) override
+    {
+        instances = leafInstances;
+    }
+
+    std::vector<std::vector<Float3>> prototypes;    ///< Local vertices of each prototype in order
+    std::vector<LeafInstance> instances;            ///< Transform of each leaf
+};
+
+/**
+* Keeps all geometry of a tree in the order it was created so it can be checked without Maya
+*/
+class RecordingOutput : public TreeOutput
+{
+public:
+
+    /**
+    * Keeps a mesh
+    */
+    virtual void AddMesh(const MeshBuffer& mesh,
+                         const std::string& name,
+                         int layer,
+                         bool leaves,
+                         const std::vector<int>&) override
+    {
+        meshes.push_back(RecordedMesh());
+        meshes.back().mesh = mesh;
+        meshes.back().name = name;
+        meshes.back().layer = layer;
+        meshes.back().leaves = leaves;
+    }
+
+    /**
+    * Counts a curve
+    */
+    virtual void AddCurve(const std::vector<Float3>&,
+                          const std::string&,
+                          int) override
+    {
+        ++curves;
+    }
+
+    /**
+    * @return the sink keeping the leaf instances
+    */
+    virtual LeafInstanceSink& AddLeafInstancer(const MeshBuffer&,
+                                               const std::string&) override
+    {
+        ++instancers;
+        return sink;
+    }
+
+    /**
+    * @return whether both outputs received exactly the same geometry in the same order
+    */
+    bool Matches(const RecordingOutput& other) const
+    {
+        if(meshes.size() != other.meshes.size() ||
+           curves != other.curves ||
+           instancers != other.instancers ||
+           sink.prototypes != other.sink.prototypes ||
+           sink.instances.size() != other.sink.instances.size())
+        {
+            return false;
+        }
+
+        for(size_t i = 0; i < meshes.size(); ++i)
+        {
+            const RecordedMesh& mesh = meshes[i];
+            const RecordedMesh& otherMesh = other.meshes[i];
+            if(mesh.name != otherMesh.name ||
+               mesh.layer != otherMesh.layer ||
+               mesh.leaves != otherMesh.leaves ||
+               !SameMesh(mesh.mesh, otherMesh.mesh))
+            {
+                return false;
+            }
+        }
+
+        for(size_t i = 0; i < sink.instances.size(); ++i)
+        {
+            if(!SameInstance(sink.instances[i], other.sink.instances[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<RecordedMesh> meshes;   ///< All meshes in the order they were added
+    RecordingSink sink;                 ///< Receives the instanced leaves
+    int curves = 0;                     ///< Number of curves added
+    int instancers = 0;                 ///< Number of instancers added
+};
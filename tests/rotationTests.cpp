@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - rotationTests.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "testHelpers.h"
+#include "matrix.h"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    const float TOLERANCE = 1.0e-5f;    ///< Largest error allowed from float rounding
+
+    /**
+    * @return whether two values are equal within the tolerance
+    */
+    bool Near(float a, float b)
+    {
+        return std::fabs(a - b) <= TOLERANCE;
+    }
+
+    /**
+    * @return whether two points are equal within the tolerance
+    */
+    bool Near(const Float3& a, const Float3& b)
+    {
+        return Near(a.x, b.x) && Near(a.y, b.y) && Near(a.z, b.z);
+    }
+
+    /**
+    * @return whether two matrices are equal within the tolerance
+    */
+    bool Near(const Matrix& a, const Matrix& b)
+    {
+        return Near(a.Right(), b.Right()) && Near(a.Up(), b.Up()) &&
+            Near(a.Forward(), b.Forward()) && Near(a.Position(), b.Position());
+    }
+
+    /**
+    * Checks a rotation about an arbitrary axis is a true rotation about that axis
+    * @param axis The normalized axis to rotate around
+    * @param radians The angle to rotate
+    */
+    void CheckRotation(const Float3& axis, float radians)
+    {
+        const Matrix rotation = Matrix::CreateRotateArbitrary(axis, radians);
+        const Float3 right = rotation.Right();
+        const Float3 up = rotation.Up();
+        const Float3 forward = rotation.Forward();
+
+        // Orthonormal and right handed
+        TEST_CHECK(Near(right.Length(), 1.0f));
+        TEST_CHECK(Near(up.Length(), 1.0f));
+        TEST_CHECK(Near(forward.Length(), 1.0f));
+        TEST_CHECK(Near(right.Dot(up), 0.0f));
+        TEST_CHECK(Near(right.Dot(forward), 0.0f));
+        TEST_CHECK(Near(up.Dot(forward), 0.0f));
+        TEST_CHECK(Near(right.Cross(up), forward));
+
+        // The axis is left where it is and the angle is kept
+        TEST_CHECK(Near(rotation * axis, axis));
+        const float trace = rotation.m11 + rotation.m22 + rotation.m33;
+        TEST_CHECK(Near(trace, 1.0f + (2.0f * std::cos(radians))));
+
+        // Rotating in place gives the same rotation
+        Matrix world;
+        world.RotateArbitrary(axis, radians);
+        TEST_CHECK(Near(world, rotation));
+
+        Matrix local;
+        local.RotateArbitraryLocal(axis, radians);
+        TEST_CHECK(Near(local, rotation));
+    }
+}
+
+int main()
+{
+    std::vector<Float3> axes;
+    axes.push_back(Float3(1.0f, 0.0f, 0.0f));
+    axes.push_back(Float3(0.0f, 1.0f, 0.0f));
+    axes.push_back(Float3(0.0f, 0.0f, 1.0f));
+    axes.push_back(Float3(0.3f, 0.8f, -0.52f).GetNormalized());
+    axes.push_back(Float3(-0.7f, 0.1f, 0.7f).GetNormalized());
+    axes.push_back(Float3(0.2f, -0.9f, 0.4f).GetNormalized());
+    axes.push_back(Float3(1.0f, 1.0f, 1.0f).GetNormalized());
+
+    const float angles[] = { 0.0f, 0.3f, -0.9f, 1.2f, 2.5f, 3.14159265f };
+    for(const Float3& axis : axes)
+    {
+        for(float radians : angles)
+        {
+            CheckRotation(axis, radians);
+        }
+    }
+    return Test::Result("rotationTests");
+}
@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - ruleSystemTests.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "testHelpers.h"
+#include "ruleSystem.h"
+#include "threadPool.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    const size_t MAX_LENGTH = 1 << 22;  ///< Longest string derived by the tests
+    const int ALWAYS = 100;             ///< Chance for a production that is always used
+
+    /**
+    * A production of a rule set
+    */
+    struct Rule
+    {
+        char symbol;                ///< The rule character to replace
+        std::string production;     ///< The symbols to replace the rule character with
+        unsigned int chance;        ///< The probability from 0-100% of the production being used
+    };
+
+    /**
+    * A set of productions to derive from an axiom
+    */
+    struct RuleSet
+    {
+        std::string axiom;              ///< Symbols the rule is derived from
+        std::vector<Rule> rules;        ///< The productions of the set
+        unsigned int branchDeath;       ///< Probability from 0-100% of a derived branch dying
+        unsigned int iterations;        ///< The number of rewrite iterations
+    };
+
+    /**
+    * Rewrites every symbol of a string once straight from the rule set, one symbol
+    * at a time, without the production table. Productions and dead branches are
+    * decided by the rolls of the rule system for the symbol's position
+    * @param set The rule set to rewrite with
+    * @param rules The rule system giving the rolls
+    * @param source The string to rewrite
+    * @param generation The current rewrite iteration
+    * @return the rewritten string
+    */
+    std::string Expand(const RuleSet& set,
+                       const RuleSystem& rules,
+                       const std::string& source,
+                       unsigned int generation)
+    {
+        std::string result;
+        for(size_t i = 0; i < source.size(); ++i)
+        {
+            // The first production added for a symbol is used
+            const Rule* rule = nullptr;
+            for(const Rule& candidate : set.rules)
+            {
+                if(candidate.symbol == source[i])
+                {
+                    rule = &candidate;
+                    break;
+                }
+            }
+
+            if(rule == nullptr)
+            {
+                result += source[i];
+                continue;
+            }
+
+            const int chance = static_cast<int>(rule->chance);
+            if(chance < ALWAYS && (chance == 0 || rules.Roll(generation, i, 0) > chance))
+            {
+                continue;
+            }
+
+            const std::string& production = rule->production;
+            for(size_t j = 0; j < production.size(); ++j)
+            {
+                // Branches closed within the production die with a roll salted by their offset
+                if(production[j] == '[' && set.branchDeath > 0 &&
+                   rules.Roll(generation, i, j + 1) < static_cast<int>(set.branchDeath))
+                {
+                    int depth = 0;
+                    size_t end = j;
+                    for(; end < production.size(); ++end)
+                    {
+                        depth += production[end] == '[' ? 1 : (production[end] == ']' ? -1 : 0);
+                        if(depth == 0)
+                        {
+                            break;
+                        }
+                    }
+
+                    if(end < production.size())
+                    {
+                        j = end;
+                        continue;
+                    }
+                }
+                result += production[j];
+            }
+        }
+        return result;
+    }
+
+    /**
+    * Derives a rule set through both the split and serial rewrite, checking each generation
+    * matches the other and the symbol by symbol expansion straight from the rule set
+    * @param set The rule set to derive
+    * @param seed The seed for stochastic productions
+    * @param pool The workers to split the rewrite across
+    * @return whether any generation was split between more than one worker
+    */
+    bool CheckRewrite(const RuleSet& set, unsigned int seed, ThreadPool& pool)
+    {
+        RuleSystem rules;
+        rules.SetSeed(seed);
+        rules.SetBranchDeath(set.branchDeath);
+        for(const Rule& rule : set.rules)
+        {
+            rules.AddRule(rule.symbol, rule.production, rule.chance);
+        }
+
+        bool split = false;
+        std::string parallel = set.axiom;
+        std::string serial = set.axiom;
+        std::string result;
+        for(unsigned int i = 0; i < set.iterations && serial.size() < MAX_LENGTH; ++i)
+        {
+            split |= pool.ChunkCount(parallel.size(), RuleSystem::MIN_REWRITE_CHUNK) > 1;
+            const std::string expanded = Expand(set, rules, serial, i);
+            rules.Rewrite(parallel, result, i, pool);
+            parallel.swap(result);
+            rules.Rewrite(serial, result, i);
+            serial.swap(result);
+            TEST_CHECK(parallel == serial);
+            TEST_CHECK(serial == expanded);
+        }
+        return split;
+    }
+}
+
+int main()
+{
+    ThreadPool pool(4);
+
+    const std::vector<RuleSet> sets =
+    {
+        // The default tree
+        { "A", { { 'A', "[>FGLLLFGLLLFLLLA]^^^^^[>FGLLLFGLLLFLLLA]^^^^^^^[>FGLLLFGLLLFLLLA]", 100 } }, 0, 9 },
+
+        // The default tree with branches pruned during derivation
+        { "A", { { 'A', "[>FGLLLFGLLLFLLLA]^^^^^[>FGLLLFGLLLFLLLA]^^^^^^^[>FGLLLFGLLLFLLLA]", 100 } }, 30, 10 },
+
+        // Stochastic productions on several symbols
+        { "X", { { 'X', "F[+X][-X]F[^X]X", 80 }, { 'F', "FF", 60 }, { 'L', "[L]", 50 } }, 0, 12 },
+
+        // Stochastic productions with nested branches pruned during derivation
+        { "XL", { { 'X', "F[+X[L]][-X[L]]FX", 90 }, { 'L', "LF[>L]", 70 } }, 45, 12 }
+    };
+
+    const unsigned int seeds[] = { 0, 1, 42, 12345, 4000000000u };
+
+    bool split = false;
+    for(const RuleSet& set : sets)
+    {
+        for(unsigned int seed : seeds)
+        {
+            split |= CheckRewrite(set, seed, pool);
+        }
+    }
+
+    // The strings must be long enough to be split or nothing was compared
+    TEST_CHECK(split);
+    return Test::Result("ruleSystemTests");
+}
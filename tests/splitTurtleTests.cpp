@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - splitTurtleTests.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "testHelpers.h"
+#include "recordingOutput.h"
+#include "treeBuilder.h"
+
+#include <limits>
+
+namespace
+{
+    const size_t NEVER_SPLIT = std::numeric_limits<size_t>::max();  ///< Keeps the whole tree on one turtle
+
+    /**
+    * Generates a tree, recording everything it creates
+    * @param parameters The parameters of the tree
+    * @param splitSymbols The smallest branch given to another worker or 0 for the default
+    * @param output Filled with the geometry of the tree
+    * @param estimate Filled with the counts of the built skeleton
+    * @return the number of branches split off to other workers
+    */
+    size_t Generate(const TreeParameters& parameters,
+                    size_t splitSymbols,
+                    RecordingOutput& output,
+                    TreeEstimate& estimate)
+    {
+        SilentProgress progress;
+        Profiler profiler;
+        TreeBuilder builder(parameters, progress);
+        builder.SetProfiler(&profiler);
+        if(splitSymbols != 0)
+        {
+            builder.SetSplitSymbols(splitSymbols);
+        }
+        TEST_CHECK(builder.BuildSkeleton());
+        estimate = builder.Estimate();
+        TEST_CHECK(builder.CreateGeometry(output, "tree"));
+
+        const Profiler::Stage* stage = profiler.Find("BuildTheTree");
+        TEST_CHECK(stage != nullptr);
+        return stage != nullptr ? Profiler::GetCount(*stage, "splits") : 0;
+    }
+
+    /**
+    * Builds a tree with large branches given to other workers and with a
+    * single turtle, checking the merged tree is identical to the serial one
+    * @param parameters The parameters of the tree
+    * @param splitSymbols The smallest branch given to another worker or 0 for the default
+    */
+    void CheckSplit(const TreeParameters& parameters, size_t splitSymbols)
+    {
+        TreeEstimate serialEstimate;
+        RecordingOutput serial;
+        TEST_CHECK(Generate(parameters, NEVER_SPLIT, serial, serialEstimate) == 0);
+
+        TreeEstimate splitEstimate;
+        RecordingOutput split;
+        const size_t splits = Generate(parameters, splitSymbols, split, splitEstimate);
+
+        // Nothing is compared unless the tree was split
+        TEST_CHECK(splits > 0);
+        TEST_CHECK(splitEstimate.branches == serialEstimate.branches);
+        TEST_CHECK(splitEstimate.sections == serialEstimate.sections);
+        TEST_CHECK(splitEstimate.leaves == serialEstimate.leaves);
+        TEST_CHECK(split.Matches(serial));
+    }
+}
+
+int main()
+{
+    // Trees large enough to be split at the default size
+    const unsigned int seeds[] = { 1, 42 };
+    for(unsigned int seed : seeds)
+    {
+        TreeParameters parameters;
+        parameters.iterations = 8;
+        parameters.tree.seed = seed;
+        parameters.tree.branchDeathProbability = 0;
+        CheckSplit(parameters, 0);
+    }
+
+    // Small splits nest several levels deep, with and without dead branches
+    const unsigned int smallSeeds[] = { 3, 7, 42 };
+    const unsigned int deaths[] = { 0, 10, 40 };
+    for(unsigned int seed : smallSeeds)
+    {
+        for(unsigned int death : deaths)
+        {
+            TreeParameters parameters;
+            parameters.iterations = 6;
+            parameters.tree.seed = seed;
+            parameters.tree.branchDeathProbability = death;
+            CheckSplit(parameters, 64);
+        }
+    }
+
+    // Stochastic productions with branches pruned during derivation
+    TreeParameters parameters;
+    parameters.iterations = 6;
+    parameters.tree.seed = 11;
+    parameters.tree.pruneBranches = true;
+    parameters.ruleIDs[0] = "A";
+    parameters.ruleStrings[0] = "[>FGLLB]^^^^^[>FGLLLA]^^^^^^^[<FLLA]";
+    parameters.ruleChances[0] = 90;
+    parameters.ruleIDs[1] = "B";
+    parameters.ruleStrings[1] = "F[+FLLB]F[-FLA]";
+    parameters.ruleChances[1] = 70;
+    CheckSplit(parameters, 64);
+
+    return Test::Result("splitTurtleTests");
+}
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - streamRuleTests.cpp
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "testHelpers.h"
+#include "recordingOutput.h"
+#include "treeBuilder.h"
+
+namespace
+{
+    /**
+    * Generates a tree, recording everything it creates
+    * @param parameters The parameters of the tree
+    * @param output Filled with the geometry of the tree
+    * @param estimate Filled with the counts of the built skeleton
+    */
+    void Generate(const TreeParameters& parameters, RecordingOutput& output, TreeEstimate& estimate)
+    {
+        SilentProgress progress;
+        TreeBuilder builder(parameters, progress);
+        TEST_CHECK(builder.BuildSkeleton());
+        estimate = builder.Estimate();
+        TEST_CHECK(builder.CreateGeometry(output, "tree"));
+    }
+
+    /**
+    * Generates a tree with the rule derived before the turtle reads it and
+    * with the rule streamed to the turtle, checking both trees are identical
+    * @param parameters The parameters of the tree
+    */
+    void CheckStream(TreeParameters parameters)
+    {
+        TreeEstimate derivedEstimate;
+        RecordingOutput derived;
+        parameters.tree.streamRule = false;
+        Generate(parameters, derived, derivedEstimate);
+
+        TreeEstimate streamedEstimate;
+        RecordingOutput streamed;
+        parameters.tree.streamRule = true;
+        Generate(parameters, streamed, streamedEstimate);
+
+        TEST_CHECK(derivedEstimate.branches > 1);
+        TEST_CHECK(streamedEstimate.branches == derivedEstimate.branches);
+        TEST_CHECK(streamedEstimate.sections == derivedEstimate.sections);
+        TEST_CHECK(streamedEstimate.leaves == derivedEstimate.leaves);
+        TEST_CHECK(!derived.meshes.empty());
+        TEST_CHECK(streamed.Matches(derived));
+    }
+
+    /**
+    * Checks streaming the default rule for several seeds and iterations
+    * @param branchDeath The probability from 0-100% of a branch dying
+    * @param pruneBranches Whether branches die during derivation rather than building
+    */
+    void CheckDefaultRule(unsigned int branchDeath, bool pruneBranches)
+    {
+        const unsigned int seeds[] = { 1, 7, 42 };
+        const unsigned int iterations[] = { 2, 4, 6 };
+        for(unsigned int seed : seeds)
+        {
+            for(unsigned int iteration : iterations)
+            {
+                TreeParameters parameters;
+                parameters.iterations = iteration;
+                parameters.tree.seed = seed;
+                parameters.tree.branchDeathProbability = branchDeath;
+                parameters.tree.pruneBranches = pruneBranches;
+                CheckStream(parameters);
+            }
+        }
+    }
+
+    /**
+    * Checks streaming stochastic productions across several symbols
+    * @param seed The seed of the tree
+    */
+    void CheckStochasticRules(unsigned int seed)
+    {
+        TreeParameters parameters;
+        parameters.iterations = 5;
+        parameters.tree.seed = seed;
+        parameters.tree.branchDeathProbability = 25;
+        parameters.ruleIDs[0] = "A";
+        parameters.ruleStrings[0] = "[>FGLLB]^^^^^[>FGLLLA]^^^^^^^[<FLLA]";
+        parameters.ruleChances[0] = 90;
+        parameters.ruleIDs[1] = "B";
+        parameters.ruleStrings[1] = "F[+FLLB]F[-FLA]";
+        parameters.ruleChances[1] = 70;
+        CheckStream(parameters);
+    }
+}
+
+int main()
+{
+    CheckDefaultRule(0, false);
+
+    // Branches killed by the turtle skip the rest of the streamed branch
+    CheckDefaultRule(10, false);
+    CheckDefaultRule(40, false);
+
+    // Branches pruned while the rule is derived
+    CheckDefaultRule(10, true);
+
+    CheckStochasticRules(3);
+    CheckStochasticRules(99);
+    return Test::Result("streamRuleTests");
+}
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////////////
+// Kara Jensen - mail@karajensen.com - testHelpers.h
+////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <iostream>
+
+/**
+* Minimal checks for the test executables, each returning non-zero from main on failure
+*/
+namespace Test
+{
+    /**
+    * @return the number of checks failed so far
+    */
+    inline int& Failures()
+    {
+        static int failures = 0;
+        return failures;
+    }
+
+    /**
+    * Records a check, reporting it if it failed
+    * @param passed Whether the check passed
+    * @param expression The text of the check
+    * @param file The file of the check
+    * @param line The line of the check
+    */
+    inline void Check(bool passed, const char* expression, const char* file, int line)
+    {
+        if(!passed)
+        {
+            ++Failures();
+            std::cerr << file << "(" << line << "): check failed: " << expression << std::endl;
+        }
+    }
+
+    /**
+    * Reports the result of the test executable
+    * @param name The name of the tests
+    * @return the code to return from main
+    */
+    inline int Result(const char* name)
+    {
+        if(Failures() > 0)
+        {
+            std::cerr << name << ": " << Failures() << " checks failed" << std::endl;
+            return 1;
+        }
+        std::cout << name << ": passed" << std::endl;
+        return 0;
+    }
+}
+
+#define TEST_CHECK(condition) Test::Check((condition), #condition, __FILE__, __LINE__)